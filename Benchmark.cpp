@@ -0,0 +1,273 @@
+﻿#define FAMILY_TREE_NO_MAIN
+#include "FileName1.cpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <sstream>
+
+/*
+ Family Tree benchmark (separate binary, shares every class with FileName1.cpp)
+ - Builds synthetic trees through the programmatic FamilyTree API (no prompts)
+ - Shapes: chain (one line of descent), wide (two very wide generations),
+   balanced (3-ary), orphans (everyone listed under root)
+ - Times insertion, findByName (hits and misses), substring and prefix name search,
+   showCenteredTree into a null sink (first render, cached repeat and a focused
+   view around one member), JSON and DOT export into the same sink, the statistics
+   sweep, publishing a version for reader threads and findByName
+   through a TreeReader on it, re-parenting, removal and teardown
+ - Prints one CSV row per measurement: shape,members,operation,items,seconds,ns_per_item
+ - Checks first that a focused view lists a mother's children and leaves out
+   members attached under root only for visibility
+
+ Build: g++ -O2 -std=c++11 -pthread Benchmark.cpp -o ftbench
+ Run:   ./ftbench [--min N] [--max N] [--shape chain|wide|balanced|orphans|all]
+*/
+
+// -------------------------
+// Class: NullBuffer (stream buffer that drops everything; render output goes here)
+// -------------------------
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) { return c == EOF ? 0 : c; }
+    streamsize xsputn(const char*, streamsize n) { return n; }
+};
+
+// -------------------------
+// Class: Stopwatch
+// -------------------------
+class Stopwatch {
+private:
+    chrono::steady_clock::time_point start;
+public:
+    Stopwatch() { start = chrono::steady_clock::now(); }
+    double seconds() const { return chrono::duration<double>(chrono::steady_clock::now() - start).count(); }
+};
+
+// -------------------------
+// Class: TreeGenerator (synthetic trees of n members, names "P<i>")
+// -------------------------
+class TreeGenerator {
+public:
+    enum Shape { CHAIN, WIDE, BALANCED, ORPHANS, SHAPE_COUNT };
+
+    static const char* shapeName(int s) {
+        static const char* names[] = { "chain", "wide", "balanced", "orphans" };
+        return names[s];
+    }
+
+    static void memberName(char* out, int i) { sprintf(out, "P%d", i); }
+
+    // member i's father: chain -> i - 1; wide -> root for the first half, then one child
+    // each for the first half (so generation 2 holds n / 2 families); balanced -> (i - 1) / 3;
+    // orphans -> none (listed under root). Mothers are left unknown.
+    static int fatherOf(int shape, int i, int n) {
+        if (shape == CHAIN) return i - 1;
+        if (shape == WIDE) { int half = n / 2; return i <= half ? 0 : i - half; }
+        if (shape == BALANCED) return (i - 1) / 3;
+        return -1;
+    }
+
+    // members[i] receives member i; returns false if the API refused an insert
+    static bool build(FamilyTree& tree, int shape, int n, FamilyMember** members) {
+        char name[32];
+        tree.reserve(n);
+        memberName(name, 0);
+        members[0] = tree.createRoot(name, 'M', true);
+        for (int i = 1; i < n; ++i) {
+            int f = fatherOf(shape, i, n);
+            memberName(name, i);
+            members[i] = tree.addMember(name, (i & 1) ? 'F' : 'M', true, f >= 0 ? members[f] : NULL, NULL);
+            if (!members[i]) return false;
+        }
+        return true;
+    }
+};
+
+// -------------------------
+// Class: Benchmark (runs every operation for one shape and size, prints CSV rows)
+// -------------------------
+class Benchmark {
+private:
+    static void report(const char* shape, int n, const char* op, long items, double secs) {
+        printf("%s,%d,%s,%ld,%.6f,%.1f\n", shape, n, op, items, secs, items ? secs * 1e9 / items : 0.0);
+        fflush(stdout);
+    }
+
+    // showFocusedTree(m, 0, down) as text
+    static string focusedView(FamilyTree& tree, FamilyMember* m, int down) {
+        ostringstream text;
+        streambuf* saved = cout.rdbuf(text.rdbuf());
+        tree.showFocusedTree(m, 0, down);
+        cout.rdbuf(saved);
+        return text.str();
+    }
+
+public:
+    // Adam (root) and Eve have Cain, Cain has Enoch; Lone has no parents (listed under root)
+    static bool checkFocus() {
+        FamilyTree tree;
+        FamilyMember* adam = tree.createRoot("Adam", 'M', true);
+        FamilyMember* eve = tree.addMember("Eve", 'F', true, NULL, NULL);
+        FamilyMember* cain = tree.addMember("Cain", 'M', true, adam, eve);
+        tree.addMember("Enoch", 'M', true, cain, NULL);
+        tree.addMember("Lone", 'F', true, NULL, NULL);
+        bool ok = true;
+        string mother = focusedView(tree, eve, 2);
+        if (mother.find("Cain") == string::npos || mother.find("Enoch") == string::npos) {
+            fprintf(stderr, "focus: Eve's view does not list her descendants\n");
+            ok = false;
+        }
+        string top = focusedView(tree, adam, 2);
+        if (top.find("Cain") == string::npos || top.find("Lone") != string::npos) {
+            fprintf(stderr, "focus: root's view lists members it has no link to\n");
+            ok = false;
+        }
+        return ok;
+    }
+
+    static bool run(int shape, int n) {
+        const char* sn = TreeGenerator::shapeName(shape);
+        FamilyMember** members = new FamilyMember * [n];
+        FamilyTree* tree = new FamilyTree();
+
+        Stopwatch insert;
+        bool ok = TreeGenerator::build(*tree, shape, n, members);
+        double insertSecs = insert.seconds();
+        if (!ok) {
+            fprintf(stderr, "%s/%d: insert refused\n", sn, n);
+            delete tree; delete[] members;
+            return false;
+        }
+        report(sn, n, "insert", n, insertSecs);
+
+        // lookups in a scrambled order (LCG), then names that are not in the tree
+        char name[32];
+        long found = 0;
+        unsigned int x = 12345u;
+        Stopwatch hits;
+        for (int k = 0; k < n; ++k) {
+            x = x * 1664525u + 1013904223u;
+            TreeGenerator::memberName(name, (int)(x % (unsigned int)n));
+            if (tree->find(name)) ++found;
+        }
+        report(sn, n, "find_hit", n, hits.seconds());
+        Stopwatch misses;
+        for (int k = 0; k < n; ++k) {
+            sprintf(name, "Q%d", k);
+            if (tree->find(name)) ++found;
+        }
+        report(sn, n, "find_miss", n, misses.seconds());
+        if (found != n) fprintf(stderr, "%s/%d: %ld of %d lookups matched\n", sn, n, found, n);
+
+        // whole-pool name scans
+        FamilyMember** results = new FamilyMember * [n];
+        Stopwatch contains;
+        int hitCount = tree->searchNames("99", false, results);
+        report(sn, n, "search_substring", n, contains.seconds());
+        Stopwatch prefix;
+        hitCount += tree->searchNames("P99", true, results);
+        report(sn, n, "search_prefix", n, prefix.seconds());
+        if (hitCount == 0) fprintf(stderr, "%s/%d: name search found nobody\n", sn, n);
+        delete[] results;
+
+        NullBuffer sink;
+        streambuf* saved = cout.rdbuf(&sink);
+        Stopwatch render;
+        tree->showCenteredTree();
+        double renderSecs = render.seconds();
+        Stopwatch cached;
+        tree->showCenteredTree();
+        double cachedSecs = cached.seconds();
+        TreeGenerator::memberName(name, n / 2); // three generations either way around a middle member
+        FamilyMember* middle = tree->find(name);
+        Stopwatch focused;
+        tree->showFocusedTree(middle, 3, 3);
+        double focusedSecs = focused.seconds();
+        cout.rdbuf(saved);
+        report(sn, n, "render", n, renderSecs);
+        report(sn, n, "render_cached", n, cachedSecs);
+        report(sn, n, "render_focused", 1, focusedSecs);
+        ostream dropped(&sink);
+        Stopwatch json;
+        tree->exportTo(dropped, false);
+        report(sn, n, "export_json", n, json.seconds());
+        Stopwatch dot;
+        tree->exportTo(dropped, true);
+        report(sn, n, "export_dot", n, dot.seconds());
+        Stopwatch sweep;
+        int counted = tree->statistics().memberCount();
+        report(sn, n, "statistics", n, sweep.seconds());
+        if (counted != n) fprintf(stderr, "%s/%d: statistics counted %d members\n", sn, n, counted);
+
+        // a version for reader threads, then the same scrambled lookups through a reader on it
+        Stopwatch publish;
+        bool published = tree->publishVersion();
+        report(sn, n, "publish_version", n, publish.seconds());
+        {
+            TreeReader reader(tree->versions());
+            TreeImage* view = reader.pin();
+            long seen = 0;
+            x = 12345u;
+            Stopwatch pinned;
+            for (int k = 0; view && k < n; ++k) {
+                x = x * 1664525u + 1013904223u;
+                TreeGenerator::memberName(name, (int)(x % (unsigned int)n));
+                if (view->find(name) >= 0) ++seen;
+            }
+            report(sn, n, "find_version", n, pinned.seconds());
+            reader.unpin();
+            if (!published || seen != n) fprintf(stderr, "%s/%d: %ld of %d version lookups matched\n", sn, n, seen, n);
+        }
+
+        // edits: the second half moves from its father's children to the same member as mother
+        // (depths stay put), then the first half after root is removed, children re-listed
+        long edited = 0;
+        Stopwatch reparent;
+        for (int i = n / 2; i < n; ++i) {
+            FamilyMember* f = members[i]->getFather();
+            if (f && tree->reparent(members[i], NULL, f)) ++edited;
+        }
+        report(sn, n, "reparent", n - n / 2, reparent.seconds());
+        Stopwatch removal;
+        for (int i = 1; i <= n / 2; ++i) if (tree->removeMember(members[i])) ++edited;
+        report(sn, n, "remove", n / 2, removal.seconds());
+        if (edited == 0) fprintf(stderr, "%s/%d: no edit was accepted\n", sn, n);
+
+        Stopwatch teardown;
+        delete tree;
+        report(sn, n, "teardown", n, teardown.seconds());
+        delete[] members;
+        return true;
+    }
+};
+
+int main(int argc, char** argv) {
+    long minN = 1000, maxN = 1000000;
+    int onlyShape = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--min") && i + 1 < argc) minN = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--max") && i + 1 < argc) maxN = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--shape") && i + 1 < argc) {
+            const char* s = argv[++i];
+            onlyShape = -2;
+            for (int k = 0; k < TreeGenerator::SHAPE_COUNT; ++k) if (!strcmp(s, TreeGenerator::shapeName(k))) onlyShape = k;
+            if (!strcmp(s, "all")) onlyShape = -1;
+            if (onlyShape == -2) { fprintf(stderr, "unknown shape '%s'\n", s); return 2; }
+        }
+        else {
+            fprintf(stderr, "usage: %s [--min N] [--max N] [--shape chain|wide|balanced|orphans|all]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (minN < 2) minN = 2;
+    if (maxN > 100000000) maxN = 100000000;
+
+    printf("shape,members,operation,items,seconds,ns_per_item\n");
+    bool ok = Benchmark::checkFocus();
+    for (int s = 0; s < TreeGenerator::SHAPE_COUNT; ++s) {
+        if (onlyShape >= 0 && s != onlyShape) continue;
+        for (long n = minN; n <= maxN; n *= 10) ok = Benchmark::run(s, (int)n) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -1,769 +1,5142 @@
-﻿#include <iostream>
-using namespace std;
-
-/*
- Advanced Family Tree (centered, dual-parent families, top-down generations)
- - Only <iostream>
- - Classes only (no struct)
- - Name max 15 chars (for layout)
- - Shows parent pairs on one line, children centered below them on next line
- - Families displayed generation by generation (top -> down)
- - Robust input handling
-*/
-
-const int MAX_NAME = 15;   // max characters to display for a name
-const int HSPACE = 6;      // horizontal spacing between families when printing
-
-// -------------------------
-// Class: FamilyMember
-// -------------------------
-class FamilyMember {
-private:
-    char name[64];
-    char gender; // 'M' or 'F'
-    bool alive;
-
-    FamilyMember* father;
-    FamilyMember* mother;
-    FamilyMember* firstChild;
-    FamilyMember* nextSibling;
-
-    void copyName(const char* src) {
-        int i = 0;
-        while (src[i] != '\0' && i < 63) { name[i] = src[i]; ++i; }
-        name[i] = '\0';
-    }
-
-public:
-    FamilyMember(const char* n = "Unknown", char g = 'M', bool isAlive = true) {
-        copyName(n);
-        gender = (g == 'M' || g == 'm') ? 'M' : 'F';
-        alive = isAlive;
-        father = mother = firstChild = nextSibling = NULL;
-    }
-
-    const char* getName() const { return name; }
-    char getGender() const { return gender; }
-    bool isAlive() const { return alive; }
-
-    void setAlive(bool a) { alive = a; }
-
-    FamilyMember* getFather() const { return father; }
-    FamilyMember* getMother() const { return mother; }
-    FamilyMember* getFirstChild() const { return firstChild; }
-    FamilyMember* getNextSibling() const { return nextSibling; }
-
-    void setFather(FamilyMember* f) { father = f; }
-    void setMother(FamilyMember* m) { mother = m; }
-    void setNextSibling(FamilyMember* s) { nextSibling = s; }
-
-    void addChild(FamilyMember* child) {
-        if (!child) return;
-        if (firstChild == NULL) firstChild = child;
-        else {
-            FamilyMember* t = firstChild;
-            while (t->nextSibling) t = t->nextSibling;
-            t->nextSibling = child;
-        }
-    }
-};
-
-// -------------------------
-// Class: FamilyPair (represents parents pair and children list)
-// We'll use a linked list of FamilyPair nodes for dynamic lists
-// -------------------------
-class FamilyPair {
-private:
-    FamilyMember* father;
-    FamilyMember* mother;
-
-    // children as an array of pointers (simple dynamic array)
-    FamilyMember** children;
-    int childCount;
-    int childCap;
-
-    FamilyPair* next;
-
-    // helper to ensure capacity
-    void ensureCap() {
-        if (childCap == 0) {
-            childCap = 4;
-            children = new FamilyMember * [childCap];
-        }
-        else if (childCount >= childCap) {
-            int nc = childCap * 2;
-            FamilyMember** tmp = new FamilyMember * [nc];
-            for (int i = 0; i < childCount; ++i) tmp[i] = children[i];
-            delete[] children;
-            children = tmp;
-            childCap = nc;
-        }
-    }
-
-public:
-    FamilyPair(FamilyMember* f = NULL, FamilyMember* m = NULL) {
-        father = f; mother = m;
-        children = NULL; childCount = 0; childCap = 0;
-        next = NULL;
-    }
-    ~FamilyPair() { if (children) delete[] children; }
-
-    void addChild(FamilyMember* c) {
-        if (!c) return;
-        ensureCap();
-        children[childCount++] = c;
-    }
-
-    int getChildCount() const { return childCount; }
-    FamilyMember* getChild(int i) const { return (i >= 0 && i < childCount) ? children[i] : NULL; }
-
-    FamilyMember* getFather() const { return father; }
-    FamilyMember* getMother() const { return mother; }
-
-    void setNext(FamilyPair* n) { next = n; }
-    FamilyPair* getNext() const { return next; }
-
-    // convenience: produce display string for parents (truncated to MAX_NAME)
-    void parentLine(char* out, int outSize) const {
-        // format: FatherName (M) - MotherName (F)
-        const char* fn = father ? father->getName() : "Unknown";
-        const char* mn = mother ? mother->getName() : "Unknown";
-
-        // Build truncated names
-        char tf[MAX_NAME + 1]; char tm[MAX_NAME + 1];
-        int i = 0;
-        for (; i < MAX_NAME && fn[i] != '\0'; ++i) tf[i] = fn[i];
-        tf[i] = '\0';
-        i = 0;
-        for (; i < MAX_NAME && mn[i] != '\0'; ++i) tm[i] = mn[i];
-        tm[i] = '\0';
-
-        // gender display
-        char fg = father ? father->getGender() : 'M';
-        char mg = mother ? mother->getGender() : 'F';
-
-        // compose (safe)
-        int p = 0;
-        int k = 0;
-        // father
-        while (tf[k] != '\0' && p < outSize - 1) out[p++] = tf[k++]; out[p] = '\0';
-        if (p < outSize - 1) { out[p++] = ' '; out[p++] = '('; out[p++] = fg; out[p++] = ')'; }
-        // separator
-        if (p < outSize - 1) { out[p++] = ' '; out[p++] = '-'; out[p++] = ' '; }
-        // mother
-        k = 0;
-        while (tm[k] != '\0' && p < outSize - 1) out[p++] = tm[k++]; out[p] = '\0';
-        if (p < outSize - 1) { out[p++] = ' '; out[p++] = '('; out[p++] = mg; out[p++] = ')'; }
-        out[(p < outSize) ? p : outSize - 1] = '\0';
-    }
-
-    // children line (concatenate child names separated by spaces, truncated)
-    void childrenLine(char* out, int outSize) const {
-        int p = 0;
-        for (int i = 0; i < childCount; ++i) {
-            const char* cn = children[i]->getName();
-            // truncated name
-            int c = 0;
-            while (c < MAX_NAME && cn[c] != '\0' && p < outSize - 1) { out[p++] = cn[c++]; }
-            if (i != childCount - 1 && p < outSize - 1) out[p++] = ' ';
-        }
-        out[p] = '\0';
-    }
-};
-
-// -------------------------
-// Class: FamilyTree
-// -------------------------
-class FamilyTree {
-private:
-    FamilyMember* root;
-
-    // helpers for dynamic arrays of members
-    FamilyMember** memberPool;
-    int memCount;
-    int memCap;
-
-    void ensureMemberCap() {
-        if (memCap == 0) {
-            memCap = 8;
-            memberPool = new FamilyMember * [memCap];
-        }
-        else if (memCount >= memCap) {
-            int nc = memCap * 2;
-            FamilyMember** tmp = new FamilyMember * [nc];
-            for (int i = 0; i < memCount; ++i) tmp[i] = memberPool[i];
-            delete[] memberPool;
-            memberPool = tmp;
-            memCap = nc;
-        }
-    }
-
-    // Add to pool for later cleanup / traversal
-    void poolAdd(FamilyMember* m) {
-        ensureMemberCap();
-        memberPool[memCount++] = m;
-    }
-
-    // simple name equality
-    bool eq(const char* a, const char* b) const {
-        int i = 0;
-        while (a[i] != '\0' || b[i] != '\0') {
-            if (a[i] != b[i]) return false;
-            ++i;
-        }
-        return true;
-    }
-
-    // find member by name (linear search in pool)
-    FamilyMember* findByName(const char* name) {
-        for (int i = 0; i < memCount; ++i) {
-            if (eq(memberPool[i]->getName(), name)) return memberPool[i];
-        }
-        return NULL;
-    }
-
-    // Recursively collect all members into pool (if we didn't maintain pool)
-    void collectAllRecursive(FamilyMember* node) {
-        if (!node) return;
-        poolAdd(node);
-        FamilyMember* c = node->getFirstChild();
-        while (c) { collectAllRecursive(c); c = c->getNextSibling(); }
-        // siblings are included when their parents traverse, root's siblings none.
-    }
-
-    // Build family pairs list for a given set of members.
-    // We'll create a linked list of FamilyPair nodes in insertion order.
-    FamilyPair* buildFamilyPairsForMembers(FamilyMember** members, int count) {
-        FamilyPair* head = NULL;
-        FamilyPair* tail = NULL;
-        // For each member, check their parents and add to corresponding pair
-        for (int i = 0; i < count; ++i) {
-            FamilyMember* child = members[i];
-            FamilyMember* f = child->getFather();
-            FamilyMember* m = child->getMother();
-
-            // If both parents NULL AND child != root, treat child as own family with Unknown parents attached to root?
-            // We'll still create a pair (father,mother) possibly both NULL representing unattached
-            // But avoid duplicates: check if pair exists already
-            FamilyPair* cur = head;
-            bool found = false;
-            while (cur) {
-                FamilyMember* cf = cur->getFather();
-                FamilyMember* cm = cur->getMother();
-                if (cf == f && cm == m) { cur->addChild(child); found = true; break; }
-                cur = cur->getNext();
-            }
-            if (!found) {
-                FamilyPair* np = new FamilyPair(f, m);
-                np->addChild(child);
-                if (tail == NULL) { head = tail = np; }
-                else { tail->setNext(np); tail = np; }
-            }
-        }
-        return head;
-    }
-
-    // helper to free family pairs linked list
-    void freeFamilyPairs(FamilyPair* head) {
-        while (head) {
-            FamilyPair* nx = head->getNext();
-            delete head;
-            head = nx;
-        }
-    }
-
-    // Helper to truncate and format a single name for display (max MAX_NAME chars)
-    static void formatName(const char* src, char* out, int outSize) {
-        int i = 0;
-        while (i < MAX_NAME && src[i] != '\0' && i < outSize - 1) { out[i] = src[i]; ++i; }
-        out[i] = '\0';
-    }
-
-public:
-    FamilyTree() { root = NULL; memberPool = NULL; memCount = memCap = 0; }
-
-    ~FamilyTree() {
-        // delete all members stored in pool
-        for (int i = 0; i < memCount; ++i) delete memberPool[i];
-        if (memberPool) delete[] memberPool;
-    }
-
-    bool hasRoot() const { return root != NULL; }
-
-    bool createRootInteractive() {
-        if (root) { cout << "Root already exists.\n"; return false; }
-        char name[64];
-        readLine("Enter root ancestor full name: ", name, 64);
-        if (name[0] == '\0') { cout << "Empty name. Aborted.\n"; return false; }
-        char g = readGender("Enter gender (M/F): ");
-        bool alive = readYesNoDefaultYes("Is ancestor alive? (y/n) [y]: ");
-        FamilyMember* m = new FamilyMember(name, g, alive);
-        root = m;
-        poolAdd(m);
-        cout << "Root '" << name << "' created.\n";
-        return true;
-    }
-
-    void addMemberInteractive() {
-        if (!root) { cout << "Create root first (option 1).\n"; return; }
-
-        char name[64];
-        readLine("Enter new member full name: ", name, 64);
-        if (name[0] == '\0') { cout << "Empty name. Aborted.\n"; return; }
-        if (findByName(name)) { cout << "Member already exists. Aborted.\n"; return; }
-
-        char gender = readGender("Enter gender (M/F): ");
-        bool alive = readYesNoDefaultYes("Is person alive? (y/n) [y]: ");
-
-        // Ask if user will provide parents
-        cout << "Do you want to specify parents for this member? (y/n): ";
-        bool specify = readYesNo(false);
-
-        FamilyMember* father = NULL;
-        FamilyMember* mother = NULL;
-
-        if (specify) {
-            char pname[64];
-            readLine("Enter father's name (or blank if unknown): ", pname, 64);
-            if (pname[0] != '\0') {
-                father = findByName(pname);
-                if (!father) {
-                    cout << "Father not found. Create father now? (y/n): ";
-                    if (readYesNo(false)) {
-                        char fg = readGender("Enter father's gender (M/F): ");
-                        bool falive = readYesNoDefaultYes("Is father alive? (y/n) [y]: ");
-                        father = new FamilyMember(pname, fg, falive);
-                        poolAdd(father);
-                        // attach to root to ensure visibility (so it's part of tree)
-                        root->addChild(father);
-                        cout << "Father created and attached under root for visibility.\n";
-                    }
-                    else {
-                        father = NULL;
-                    }
-                }
-            }
-
-            readLine("Enter mother's name (or blank if unknown): ", pname, 64);
-            if (pname[0] != '\0') {
-                mother = findByName(pname);
-                if (!mother) {
-                    cout << "Mother not found. Create mother now? (y/n): ";
-                    if (readYesNo(false)) {
-                        char mg = readGender("Enter mother's gender (M/F): ");
-                        bool malive = readYesNoDefaultYes("Is mother alive? (y/n) [y]: ");
-                        mother = new FamilyMember(pname, mg, malive);
-                        poolAdd(mother);
-                        root->addChild(mother);
-                        cout << "Mother created and attached under root for visibility.\n";
-                    }
-                    else {
-                        mother = NULL;
-                    }
-                }
-            }
-
-            // If one parent provided and other missing, ask to create spouse optionally
-            if (father && !mother) {
-                cout << "Mother missing. Create/set mother now? (y/n): ";
-                if (readYesNo(false)) {
-                    char pname2[64];
-                    readLine("Enter mother's name: ", pname2, 64);
-                    if (pname2[0] != '\0') {
-                        FamilyMember* mnode = findByName(pname2);
-                        if (!mnode) {
-                            char mg = readGender("Enter mother's gender (M/F) [F suggested]: ");
-                            bool malive = readYesNoDefaultYes("Is mother alive? (y/n) [y]: ");
-                            mnode = new FamilyMember(pname2, mg, malive);
-                            poolAdd(mnode);
-                            root->addChild(mnode);
-                        }
-                        mother = mnode;
-                    }
-                }
-            }
-            else if (mother && !father) {
-                cout << "Father missing. Create/set father now? (y/n): ";
-                if (readYesNo(false)) {
-                    char pname2[64];
-                    readLine("Enter father's name: ", pname2, 64);
-                    if (pname2[0] != '\0') {
-                        FamilyMember* mnode = findByName(pname2);
-                        if (!mnode) {
-                            char mg = readGender("Enter father's gender (M/F) [M suggested]: ");
-                            bool malive = readYesNoDefaultYes("Is father alive? (y/n) [y]: ");
-                            mnode = new FamilyMember(pname2, mg, malive);
-                            poolAdd(mnode);
-                            root->addChild(mnode);
-                        }
-                        father = mnode;
-                    }
-                }
-            }
-        }
-
-        FamilyMember* nm = new FamilyMember(name, gender, alive);
-        poolAdd(nm);
-
-        // link parents
-        if (father) {
-            nm->setFather(father);
-            father->addChild(nm);
-        }
-        if (mother) {
-            nm->setMother(mother);
-            // if father not present, attach child to mother list for visibility
-            if (!father) mother->addChild(nm);
-        }
-        if (!father && !mother) {
-            // attach under root to keep tree connected
-            root->addChild(nm);
-            cout << "No parents specified; member attached under root for visibility.\n";
-        }
-
-        cout << "Member '" << name << "' added successfully.\n";
-    }
-
-    void markLateInteractive() {
-        if (!root) { cout << "No tree exists.\n"; return; }
-        char name[64];
-        readLine("Enter member name to mark as Late: ", name, 64);
-        if (name[0] == '\0') { cout << "Empty name.\n"; return; }
-        FamilyMember* m = findByName(name);
-        if (!m) { cout << "Member not found.\n"; return; }
-        if (!m->isAlive()) { cout << "Already marked Late.\n"; return; }
-        cout << "Confirm marking '" << m->getName() << "' as Late? (y/n): ";
-        if (readYesNo(false)) {
-            m->setAlive(false);
-            cout << "Marked Late.\n";
-        }
-        else cout << "Cancelled.\n";
-    }
-
-    // Build top-down generations as families:
-    // Level 0: family pairs whose parents are both NULL (i.e., top ancestors or root and spouse)
-    // Level 1: families formed by children of Level 0 families, etc.
-    void showCenteredTree() {
-        if (!root) { cout << "No tree. Create root first.\n"; return; }
-
-        // gather all members into array (memberPool already maintained)
-        // We'll create array of pointers pointing to all members
-        FamilyMember** all = memberPool;
-        int total = memCount;
-
-        // Build mapping child -> parent pair is implicit. We'll find families for current level by checking parents = something
-        // We'll use a simple iterative BFS by generation: start with families where both parents are NULL (top-level families)
-        // But many real trees have root as an ancestor with no parents. We'll treat families by parent pair identity.
-
-        // To avoid complexity of true spatial layout, we'll produce centered blocks per family per generation.
-        // Step 1: For generation 0, find families where parents have no parents themselves (parents are top)
-        // We'll instead pick families where at least one parent is root or has no parents.
-        // Simpler: start generation 0 as families that include root as a parent OR members with no parents attached (root)
-        // Then iteratively build next generations using the children of families in previous generation.
-
-        // Build initial family list for generation: families that contain members who have father==root or mother==root or whose parents are both NULL and the member is root.
-        FamilyPair* genHead = NULL;
-        FamilyPair* genTail = NULL;
-
-        // Helper to append a pair node to list
-        auto appendPair = [&](FamilyPair* p) {
-            if (!genHead) { genHead = genTail = p; }
-            else { genTail->setNext(p); genTail = p; }
-            };
-
-        // For every member, if their parent pair includes root or both parents null and member is root, include that pair
-        for (int i = 0; i < total; ++i) {
-            FamilyMember* ch = all[i];
-            FamilyMember* f = ch->getFather();
-            FamilyMember* m = ch->getMother();
-            bool include = false;
-            if (f == root || m == root) include = true;
-            if (!f && !m && ch == root) include = true;
-            if (!include) continue;
-
-            // check existing pair in genHead
-            FamilyPair* cur = genHead; bool found = false;
-            while (cur) {
-                if (cur->getFather() == f && cur->getMother() == m) { cur->addChild(ch); found = true; break; }
-                cur = cur->getNext();
-            }
-            if (!found) {
-                FamilyPair* np = new FamilyPair(f, m);
-                np->addChild(ch);
-                appendPair(np);
-            }
-        }
-
-        // Now we will print generation by generation using family pairs, and build next generation list from children who are parents themselves
-        int generation = 0;
-        FamilyPair* currentGen = genHead;
-
-        if (!currentGen) {
-            // Fallback: if nothing found (strange), create one family containing root
-            FamilyPair* np = new FamilyPair(NULL, NULL);
-            np->addChild(root);
-            currentGen = np;
-        }
-
-        cout << "\n=== CENTERED FAMILY TREE ===\n\n";
-
-        while (currentGen != NULL) {
-            // For current generation, compute widths for each family block (parentLine and childrenLine)
-            // We'll build arrays by traversing linked list to count nodes
-            int count = 0;
-            for (FamilyPair* t = currentGen; t; t = t->getNext()) ++count;
-
-            // dynamic arrays
-            char** parentLines = new char* [count];
-            char** childLines = new char* [count];
-            int* widths = new int[count];
-            for (int i = 0; i < count; ++i) {
-                parentLines[i] = new char[256];
-                childLines[i] = new char[256];
-                parentLines[i][0] = childLines[i][0] = '\0';
-            }
-
-            // fill arrays
-            int idx = 0;
-            int maxWidth = 0;
-            for (FamilyPair* t = currentGen; t; t = t->getNext()) {
-                t->parentLine(parentLines[idx], 256);
-                t->childrenLine(childLines[idx], 256);
-                // compute display width (string length)
-                int w = 0; while (parentLines[idx][w] != '\0') ++w;
-                int w2 = 0; while (childLines[idx][w2] != '\0') ++w2;
-                int ww = w > w2 ? w : w2;
-                if (ww < 6) ww = 6; // minimal width for neatness
-                widths[idx] = ww;
-                if (ww > maxWidth) maxWidth = ww;
-                ++idx;
-            }
-
-            // Now print parent line for all families centered in their width, separated by HSPACE
-            // We'll pad each parent's line to widths[i], centering text
-            // totalLineWidth for this generation
-            int totalLineWidth = 0;
-            for (int i = 0; i < count; ++i) totalLineWidth += widths[i];
-            totalLineWidth += (count - 1) * HSPACE;
-
-            // we will print two rows: parents row and children row
-            // Parents row
-            for (int i = 0; i < count; ++i) {
-                // center parentLines[i] in widths[i]
-                int len = 0; while (parentLines[i][len] != '\0') ++len;
-                int padLeft = (widths[i] - len) / 2;
-                for (int sp = 0; sp < padLeft; ++sp) cout << ' ';
-                cout << parentLines[i];
-                for (int sp = 0; sp < widths[i] - padLeft - len; ++sp) cout << ' ';
-                if (i != count - 1) for (int s = 0; s < HSPACE; ++s) cout << ' ';
-            }
-            cout << '\n';
-
-            // Print connector line: draw a vertical connector from parents to center and a down connector to children
-            for (int i = 0; i < count; ++i) {
-                int len = 0; while (parentLines[i][len] != '\0') ++len;
-                int padLeft = (widths[i] - len) / 2;
-                int parentCenter = padLeft + len / 2; // approximate center pos inside block
-
-                // print spaces up to parentCenter
-                int pre = parentCenter;
-                for (int s = 0; s < pre; ++s) cout << ' ';
-                cout << "│";
-                // pad rest of block
-                for (int s = pre + 1; s < widths[i]; ++s) cout << ' ';
-                if (i != count - 1) for (int s = 0; s < HSPACE; ++s) cout << ' ';
-            }
-            cout << '\n';
-
-            // Children row
-            for (int i = 0; i < count; ++i) {
-                int len = 0; while (childLines[i][len] != '\0') ++len;
-                int padLeft = (widths[i] - len) / 2;
-                for (int sp = 0; sp < padLeft; ++sp) cout << ' ';
-                cout << childLines[i];
-                for (int sp = 0; sp < widths[i] - padLeft - len; ++sp) cout << ' ';
-                if (i != count - 1) for (int s = 0; s < HSPACE; ++s) cout << ' ';
-            }
-            cout << "\n\n";
-
-            // build next generation: families where parents are members listed in children of these families
-            // Gather children pointers into an array
-            FamilyPair* nextGenHead = NULL; FamilyPair* nextGenTail = NULL;
-            // Collect children pointers
-            // We'll create an array of children pointers (without duplicates)
-            FamilyMember** childList = NULL; int childCount = 0; int childCap = 0;
-            auto childEnsure = [&]() {
-                if (childCap == 0) { childCap = 8; childList = new FamilyMember * [childCap]; }
-                else if (childCount >= childCap) {
-                    int nc = childCap * 2;
-                    FamilyMember** tmp = new FamilyMember * [nc];
-                    for (int ii = 0; ii < childCount; ++ii) tmp[ii] = childList[ii];
-                    delete[] childList;
-                    childList = tmp;
-                    childCap = nc;
-                }
-                };
-
-            // fill childList from currentGen FamilyPair children
-            for (int j = 0; j < count; ++j) {
-                for (int c = 0; c < 10000; ++c) {
-                    // safe access via childLines length: but we used FamilyPair getter earlier; better to extract children via getChild
-                    break;
-                }
-            }
-            // Instead iterate currentGen again to collect children pointers
-            int idx2 = 0;
-            for (FamilyPair* t = currentGen; t; t = t->getNext()) {
-                int cc = t->getChildCount();
-                for (int k = 0; k < cc; ++k) {
-                    FamilyMember* ch = t->getChild(k);
-                    // avoid duplicates
-                    bool dup = false;
-                    for (int z = 0; z < childCount; ++z) if (childList[z] == ch) { dup = true; break; }
-                    if (!dup) {
-                        childEnsure();
-                        childList[childCount++] = ch;
-                    }
-                }
-            }
-
-            // For each child in childList, if this child is a parent of someone (i.e., has firstChild), we create a FamilyPair for that child's children
-            for (int i = 0; i < childCount; ++i) {
-                FamilyMember* potentialParent = childList[i];
-                if (!potentialParent->getFirstChild()) continue; // not a parent
-                // For each of potentialParent's children, we need to find the partner (spouse) pointer: child's father/mother combined
-                // For each child c = potentialParent->firstChild ... determine the pair (father,mother) and add family pair
-                FamilyMember* cnode = potentialParent->getFirstChild();
-                while (cnode) {
-                    FamilyMember* f = cnode->getFather();
-                    FamilyMember* m = cnode->getMother();
-                    // find existing pair in nextGenHead
-                    FamilyPair* cur = nextGenHead;
-                    bool found = false;
-                    while (cur) {
-                        if (cur->getFather() == f && cur->getMother() == m) { cur->addChild(cnode); found = true; break; }
-                        cur = cur->getNext();
-                    }
-                    if (!found) {
-                        FamilyPair* np = new FamilyPair(f, m);
-                        np->addChild(cnode);
-                        if (!nextGenHead) nextGenHead = nextGenTail = np;
-                        else { nextGenTail->setNext(np); nextGenTail = np; }
-                    }
-                    cnode = cnode->getNextSibling();
-                }
-            }
-
-            // cleanup temp arrays
-            for (int i = 0; i < count; ++i) {
-                delete[] parentLines[i];
-                delete[] childLines[i];
-            }
-            delete[] parentLines;
-            delete[] childLines;
-            delete[] widths;
-
-            if (childList) delete[] childList;
-
-            // free current generation family pairs and move to next
-            FamilyPair* old = currentGen;
-            currentGen = nextGenHead;
-            // we free old generation list
-            FamilyPair* it = old;
-            while (it) { FamilyPair* nx = it->getNext(); delete it; it = nx; }
-            generation++;
-        }
-
-        cout << "=== END OF TREE ===\n";
-    }
-
-    // ---------- Utilities: safe input ----------
-    static void readLine(const char* prompt, char* buffer, int size) {
-        cout << prompt;
-        // clear newline
-        if (cin.peek() == '\n') cin.get();
-        cin.getline(buffer, size);
-    }
-
-    static char readGender(const char* prompt) {
-        char g;
-        while (true) {
-            cout << prompt;
-            cin >> g;
-            if (g == 'M' || g == 'm' || g == 'F' || g == 'f') {
-                if (cin.peek() == '\n') cin.get();
-                return (g == 'M' || g == 'm') ? 'M' : 'F';
-            }
-            else {
-                cout << "Invalid gender. Enter M or F.\n";
-                cin.clear();
-                if (cin.peek() != '\n') cin.ignore(1000, '\n');
-            }
-        }
-    }
-
-    static bool readYesNo(bool defaultNo) {
-        char ch;
-        while (true) {
-            cin >> ch;
-            if (ch == 'y' || ch == 'Y') { if (cin.peek() == '\n') cin.get(); return true; }
-            if (ch == 'n' || ch == 'N') { if (cin.peek() == '\n') cin.get(); return false; }
-            cout << "Please enter y or n: ";
-            if (cin.peek() != '\n') cin.ignore(1000, '\n');
-        }
-    }
-    static bool readYesNoDefaultYes(const char* prompt) {
-        cout << prompt;
-        char ch;
-        while (true) {
-            cin >> ch;
-            if (ch == 'y' || ch == 'Y') { if (cin.peek() == '\n') cin.get(); return true; }
-            if (ch == 'n' || ch == 'N') { if (cin.peek() == '\n') cin.get(); return false; }
-            cout << "Please enter y or n: ";
-            if (cin.peek() != '\n') cin.ignore(1000, '\n');
-        }
-    }
-
-    // ---------- For Menu & testing ----------
-    void showAllNames() {
-        cout << "\nAll members:\n";
-        for (int i = 0; i < memCount; ++i) cout << "- " << memberPool[i]->getName() << "\n";
-    }
-};
-
-// -------------------------
-// Menu (short main logic)
-// -------------------------
-class Menu {
-private:
-    FamilyTree tree;
-    int readChoice() {
-        int c;
-        while (!(cin >> c)) {
-            cout << "Invalid number, enter again: ";
-            cin.clear(); cin.ignore(1000, '\n');
-        }
-        if (cin.peek() == '\n') cin.get();
-        return c;
-    }
-public:
-    void run() {
-        cout << "===== CENTERED FAMILY TREE SYSTEM =====\n";
-        while (true) {
-            cout << "\n1. Create Root Ancestor\n2. Add Member\n3. Mark Member as Late\n4. Show Centered Tree\n5. List All Members\n0. Exit\nEnter choice: ";
-            int ch = readChoice();
-            if (ch == 0) { cout << "Exiting...\n"; break; }
-            if (ch == 1) tree.createRootInteractive();
-            else if (ch == 2) tree.addMemberInteractive();
-            else if (ch == 3) tree.markLateInteractive();
-            else if (ch == 4) tree.showCenteredTree();
-            else if (ch == 5) tree.showAllNames();
-            else cout << "Invalid choice.\n";
-        }
-    }
-};
-int main() {
-    Menu m;
-    m.run();
-    return 0;
-}
\ No newline at end of file
+﻿#include <iostream>
+#include <fstream>
+#include <new>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define FT_POSIX_IO
+#endif
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+/*
+ Advanced Family Tree (centered, dual-parent families, top-down generations)
+ - Standard C++11 library, plus optional POSIX I/O (FT_POSIX_IO: journal syncs, mapped
+   snapshots and images) and SSE2/AVX2 paths where the platform and compiler provide them
+ - Classes only (no struct)
+ - Name max 15 chars (for layout)
+ - Shows parent pairs on one line, children centered below them on next line
+ - Families displayed generation by generation (top -> down)
+ - Robust input handling
+*/
+
+const int MAX_NAME = 15;   // max characters to display for a name
+const int HSPACE = 6;      // horizontal spacing between families when printing
+const int LINE_BUF = 256;  // display line limit per family block (LINE_BUF - 1 chars)
+
+// -------------------------
+// Class: Stats (opt-in hot-path counters and per-generation render timing)
+// Only compiled in with -DFAMILY_TREE_STATS; collection is then switched on from
+// the menu (option 12) or with the --stats flag. Without the define the FT_*
+// macros below expand to empty statements, so release builds carry no trace of it.
+// Counters are atomic because wide generations bump them from worker threads.
+// -------------------------
+#ifdef FAMILY_TREE_STATS
+class Stats {
+public:
+    enum Counter {
+        NAME_LOOKUPS, NAME_PROBES, CHILD_LINKS, PAIR_CHILD_GROWS, MEMBER_POOL_GROWS, BUFFER_GROWS,
+        ARENA_CHUNKS, PAIRS_CREATED, PAIR_BYTES, RENDERS, RENDER_REPLAYS, RENDER_RESTARTS,
+        GENERATIONS, RENDER_BYTES, JOURNAL_RECORDS, JOURNAL_SYNCS, MEMBERS_REMOVED, MEMBER_SLOTS_REUSED,
+        COUNTER_COUNT
+    };
+
+    static bool enabled;
+    static atomic<unsigned long long> counters[COUNTER_COUNT];
+    static long long genNanos;     // total time spent on laid-out generations
+    static long long slowestNanos;
+    static int slowestGen;
+
+    static void add(Counter c, unsigned long long n) { counters[c].fetch_add(n, memory_order_relaxed); }
+    static unsigned long long get(Counter c) { return counters[c].load(memory_order_relaxed); }
+
+    static long long now() {
+        return (long long)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void generationDone(int gen, long long startNanos) {
+        long long d = now() - startNanos;
+        add(GENERATIONS, 1);
+        genNanos += d;
+        if (d > slowestNanos) { slowestNanos = d; slowestGen = gen; }
+    }
+
+    static void reset() {
+        for (int i = 0; i < COUNTER_COUNT; ++i) counters[i].store(0, memory_order_relaxed);
+        genNanos = slowestNanos = 0;
+        slowestGen = -1;
+    }
+
+    static void report(ostream& os) {
+        unsigned long long lookups = get(NAME_LOOKUPS), gens = get(GENERATIONS);
+        os << "\n--- Instrumentation report ---\n";
+        os << "name lookups          : " << lookups << " (" << get(NAME_PROBES) << " index slots compared";
+        if (lookups) os << ", " << (double)get(NAME_PROBES) / (double)lookups << " per lookup";
+        os << ")\n";
+        os << "child links           : " << get(CHILD_LINKS) << " (one step each)\n";
+        os << "reallocations         : member pool " << get(MEMBER_POOL_GROWS) << ", pair child arrays "
+           << get(PAIR_CHILD_GROWS) << ", buffers " << get(BUFFER_GROWS) << ", arena chunks " << get(ARENA_CHUNKS) << "\n";
+        os << "family pairs          : " << get(PAIRS_CREATED) << " (" << get(PAIR_BYTES) << " bytes)\n";
+        os << "renders               : " << get(RENDERS) << " (" << get(RENDER_REPLAYS) << " replayed from cache, "
+           << get(RENDER_RESTARTS) << " partly rebuilt)\n";
+        os << "generations laid out  : " << gens << " in " << genNanos / 1e6 << " ms";
+        if (gens) os << " (avg " << genNanos / 1e3 / (double)gens << " us, slowest #" << slowestGen << " "
+                     << slowestNanos / 1e6 << " ms)";
+        os << "\n";
+        os << "bytes written (render): " << get(RENDER_BYTES) << "\n";
+        os << "journal               : " << get(JOURNAL_RECORDS) << " records in " << get(JOURNAL_SYNCS) << " syncs\n";
+        os << "members removed       : " << get(MEMBERS_REMOVED) << " (" << get(MEMBER_SLOTS_REUSED) << " freed slots reused)\n";
+    }
+};
+bool Stats::enabled = false;
+atomic<unsigned long long> Stats::counters[Stats::COUNTER_COUNT];
+long long Stats::genNanos = 0;
+long long Stats::slowestNanos = 0;
+int Stats::slowestGen = -1;
+
+#define FT_COUNT(counter, n) do { if (Stats::enabled) Stats::add(Stats::counter, (n)); } while (0)
+#define FT_CLOCK(var) long long var = Stats::enabled ? Stats::now() : 0
+#define FT_GENERATION_DONE(gen, var) do { if (Stats::enabled) Stats::generationDone((gen), (var)); } while (0)
+#else
+#define FT_COUNT(counter, n) do { } while (0)
+#define FT_CLOCK(var) do { } while (0)
+#define FT_GENERATION_DONE(gen, var) do { } while (0)
+#endif
+
+// -------------------------
+// Class: Arena (bump allocator over chunked storage)
+// Objects never move once placed, and reset() releases everything in one step
+// while keeping the chunks for reuse. Destructors are NOT run, so only
+// trivially destructible objects (FamilyMember, FamilyPair) may live here.
+// -------------------------
+class Arena {
+private:
+    static const size_t ALIGN = 16;
+
+    char** chunks;
+    size_t* sizes;
+    int chunkCount;
+    int chunkCap;
+    int cur;          // chunk currently being carved
+    size_t offset;    // next free byte in chunks[cur]
+    size_t firstSize; // size of the first chunk; later chunks double
+
+    void addChunk(size_t minBytes) {
+        size_t sz = chunkCount ? sizes[chunkCount - 1] * 2 : firstSize;
+        if (sz > (size_t)1 << 20) sz = (size_t)1 << 20;
+        if (sz < minBytes) sz = minBytes;
+        if (chunkCount >= chunkCap) {
+            int nc = chunkCap ? chunkCap * 2 : 8;
+            char** tc = new char* [nc];
+            size_t* ts = new size_t[nc];
+            for (int i = 0; i < chunkCount; ++i) { tc[i] = chunks[i]; ts[i] = sizes[i]; }
+            if (chunks) { delete[] chunks; delete[] sizes; }
+            chunks = tc; sizes = ts; chunkCap = nc;
+        }
+        chunks[chunkCount] = new char[sz];
+        FT_COUNT(ARENA_CHUNKS, 1);
+        sizes[chunkCount] = sz;
+        ++chunkCount;
+    }
+
+public:
+    Arena(size_t firstChunkBytes = 4096) {
+        chunks = NULL; sizes = NULL;
+        chunkCount = chunkCap = 0;
+        cur = 0; offset = 0;
+        firstSize = firstChunkBytes;
+    }
+    ~Arena() {
+        for (int i = 0; i < chunkCount; ++i) delete[] chunks[i];
+        if (chunks) { delete[] chunks; delete[] sizes; }
+    }
+
+    // raw storage, aligned to ALIGN bytes
+    void* alloc(size_t bytes) {
+        bytes = (bytes + ALIGN - 1) & ~(ALIGN - 1);
+        // move to the next chunk (reusing a kept one when it is big enough)
+        while (cur < chunkCount && offset + bytes > sizes[cur]) { ++cur; offset = 0; }
+        if (cur >= chunkCount) { addChunk(bytes); cur = chunkCount - 1; offset = 0; }
+        void* p = chunks[cur] + offset;
+        offset += bytes;
+        return p;
+    }
+
+    // forget every allocation; chunks stay allocated for the next round
+    void reset() { cur = 0; offset = 0; }
+};
+
+// -------------------------
+// Class: SmallArray (growable array of plain values, the first N stored inline)
+// For pointers, ints and other trivially copyable types. Growth doubles the capacity with one
+// memcpy into the new buffer, taken from an Arena when one is given (reclaimed with it, so
+// arrays inside arena objects never need a destructor) or from the heap otherwise. The new
+// buffer is allocated before anything changes, so a failed allocation leaves the array as it
+// was. Moving steals a heap buffer and copies inline elements; copying is not allowed.
+// -------------------------
+template <class T, int N>
+class SmallArray {
+private:
+    T* items;
+    int count;
+    int cap;
+    Arena* arena;  // source of growth buffers, NULL = heap
+    T local[N];
+
+    bool ownsHeap() const { return items != local && !arena; }
+
+    void grow(int want) {
+        int nc = cap * 2 > want ? cap * 2 : want;
+        T* tmp = arena ? (T*)arena->alloc((size_t)nc * sizeof(T)) : new T[nc];
+        if (count) memcpy(tmp, items, (size_t)count * sizeof(T));
+        if (ownsHeap()) delete[] items;
+        items = tmp;
+        cap = nc;
+    }
+
+    void take(SmallArray& o) {
+        arena = o.arena;
+        count = o.count;
+        if (o.items == o.local) {
+            items = local;
+            cap = N;
+            if (count) memcpy(local, o.local, (size_t)count * sizeof(T));
+        }
+        else { items = o.items; cap = o.cap; }
+        o.items = o.local; o.cap = N; o.count = 0;
+    }
+
+public:
+    explicit SmallArray(Arena* a = NULL) { items = local; count = 0; cap = N; arena = a; }
+    ~SmallArray() { if (ownsHeap()) delete[] items; }
+    SmallArray(SmallArray&& o) { take(o); }
+    SmallArray& operator=(SmallArray&& o) {
+        if (this != &o) {
+            if (ownsHeap()) delete[] items;
+            take(o);
+        }
+        return *this;
+    }
+    SmallArray(const SmallArray&) = delete;
+    SmallArray& operator=(const SmallArray&) = delete;
+
+    // room for n elements in total (at least doubling, so repeated calls stay amortized)
+    void reserve(int n) { if (n > cap) grow(n); }
+    // n elements; new ones are left unset and old contents are kept
+    void resize(int n) { reserve(n); count = n; }
+    void clear() { count = 0; }
+
+    // true if the next push has to allocate
+    bool full() const { return count == cap; }
+    void push(T v) {
+        if (count == cap) grow(count + 1);
+        items[count++] = v;
+    }
+    T pop() { return items[--count]; }
+
+    T& operator[](int i) { return items[i]; }
+    const T& operator[](int i) const { return items[i]; }
+    T* data() { return items; }
+    const T* data() const { return items; }
+    int size() const { return count; }
+    int capacity() const { return cap; }
+};
+
+// -------------------------
+// Class: LineBuffer (growable output buffer, written with one ostream::write)
+// The renderer composes a whole row here instead of inserting char by char.
+// -------------------------
+class LineBuffer {
+private:
+    char* buf;
+    int len;
+    int cap;
+
+public:
+    LineBuffer() { buf = NULL; len = cap = 0; }
+    ~LineBuffer() { if (buf) delete[] buf; }
+
+    // make room for n more bytes (capacity is kept across flushes)
+    void reserve(int n) {
+        if (len + n <= cap) return;
+        int nc = cap ? cap : 256;
+        while (nc < len + n) nc *= 2;
+        FT_COUNT(BUFFER_GROWS, 1);
+        char* tmp = new char[nc];
+        for (int i = 0; i < len; ++i) tmp[i] = buf[i];
+        if (buf) delete[] buf;
+        buf = tmp;
+        cap = nc;
+    }
+
+    void put(char c) { reserve(1); buf[len++] = c; }
+    void put(const char* s, int n) {
+        reserve(n);
+        for (int i = 0; i < n; ++i) buf[len + i] = s[i];
+        len += n;
+    }
+    void fill(char c, int n) {
+        if (n <= 0) return;
+        reserve(n);
+        for (int i = 0; i < n; ++i) buf[len + i] = c;
+        len += n;
+    }
+
+    // append n bytes to be written in place (e.g. by several threads, each in its own range)
+    char* extend(int n) {
+        reserve(n);
+        char* p = buf + len;
+        len += n;
+        return p;
+    }
+
+    int size() const { return len; }
+    const char* data() const { return buf; }
+    void truncate(int n) { if (n < len) len = n; }
+    void flushTo(ostream& os) {
+        if (len) os.write(buf, len);
+        len = 0;
+    }
+};
+
+// -------------------------
+// Class: WorkSplitter (run fn(begin, end) over contiguous slices of [0, n))
+// Slices hold at least `grain` items and one of them runs on the calling thread;
+// below 2 * grain nothing is started, so small trees never pay for threads. The
+// slices are disjoint, so a loop body that only writes its own items' slots gives
+// exactly the result of the serial loop.
+// -------------------------
+class WorkSplitter {
+public:
+    static const int MAX_WORKERS = 64;
+
+    // queried once: hardware_concurrency() is a system call on some platforms
+    static int workers() {
+        static const int count = detectWorkers();
+        return count;
+    }
+
+    static int detectWorkers() {
+        int h = (int)thread::hardware_concurrency();
+        if (h < 1) h = 1;
+        return h < MAX_WORKERS ? h : MAX_WORKERS;
+    }
+
+    // number of slices run() / runSlices() cut n items into (1 = serial)
+    static int slices(int n, int grain) {
+        int parts = grain > 0 ? n / grain : 1;
+        if (parts < 2) return 1;
+        int w = workers();
+        if (parts > w) parts = w;
+        return parts < 1 ? 1 : parts;
+    }
+
+    // fn(slice, begin, end): slice k always gets the same range for the same n and grain,
+    // so per-slice results of one call line up with those of the next
+    template <class Fn>
+    static void runSlices(int n, int grain, Fn fn) {
+        int parts = slices(n, grain);
+        if (parts < 2) { fn(0, 0, n); return; }
+        thread pool[MAX_WORKERS];
+        int step = (n + parts - 1) / parts;
+        for (int k = 1; k < parts; ++k) {
+            int b = k * step < n ? k * step : n, e = b + step < n ? b + step : n;
+            pool[k] = thread(fn, k, b, e);
+        }
+        fn(0, 0, step < n ? step : n);
+        for (int k = 1; k < parts; ++k) pool[k].join();
+    }
+
+    template <class Fn>
+    static void run(int n, int grain, Fn fn) {
+        runSlices(n, grain, [&fn](int, int b, int e) { fn(b, e); });
+    }
+};
+
+// -------------------------
+// Class: NamePool (interned member names in one contiguous byte array)
+// Every name is stored once, NUL-terminated, in creation order; members keep
+// offset + length + hash into it. Offsets survive growth, but pointers returned
+// by text() are only valid until the next add (re-fetch them after adding members).
+// -------------------------
+class NamePool {
+private:
+    char* bytes;
+    int len;
+    int cap;
+
+public:
+    static const int MAX_LEN = 63; // longest stored name, as with the old char[64] buffers
+
+    NamePool() { bytes = NULL; len = cap = 0; }
+    ~NamePool() { if (bytes) delete[] bytes; }
+
+    void reserve(int n) {
+        if (len + n <= cap) return;
+        int nc = cap ? cap : 1024;
+        while (nc < len + n) nc *= 2;
+        FT_COUNT(BUFFER_GROWS, 1);
+        char* tmp = new char[nc];
+        for (int i = 0; i < len; ++i) tmp[i] = bytes[i];
+        if (bytes) delete[] bytes;
+        bytes = tmp;
+        cap = nc;
+    }
+
+    // copy n bytes plus a terminator; returns the offset of the copy
+    int add(const char* s, int n) {
+        reserve(n + 1);
+        int off = len;
+        for (int i = 0; i < n; ++i) bytes[len + i] = s[i];
+        bytes[len + n] = '\0';
+        len += n + 1;
+        return off;
+    }
+
+    // append an already NUL-separated name table verbatim (snapshot load)
+    int addBlock(const char* b, int n) {
+        reserve(n);
+        int off = len;
+        for (int i = 0; i < n; ++i) bytes[len + i] = b[i];
+        len += n;
+        return off;
+    }
+
+    const char* text(int off) const { return bytes + off; }
+    const char* data() const { return bytes; }
+    int size() const { return len; }
+
+    // Offset of the first occurrence of s[0..n) (n >= 1) at or after from, -1 if none.
+    // Candidates are positions whose first and last bytes both match, tested 32 (AVX2)
+    // or 16 (SSE2) positions per step; only those are compared in full. A needle without
+    // NUL bytes never matches across two names.
+    int findText(const char* s, int n, int from) const {
+        int last = len - n; // last possible start
+        int i = from;
+#if defined(__AVX2__)
+        const __m256i head32 = _mm256_set1_epi8(s[0]);
+        const __m256i tail32 = _mm256_set1_epi8(s[n - 1]);
+        for (; i + 31 <= last; i += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(bytes + i));
+            __m256i z = _mm256_loadu_si256((const __m256i*)(bytes + i + n - 1));
+            unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(a, head32), _mm256_cmpeq_epi8(z, tail32)));
+            for (; mask; mask &= mask - 1) {
+                int k = i + __builtin_ctz(mask);
+                if (sameBytes(bytes + k + 1, s + 1, n - 2)) return k;
+            }
+        }
+#endif
+#if defined(__SSE2__)
+        const __m128i head = _mm_set1_epi8(s[0]);
+        const __m128i tail = _mm_set1_epi8(s[n - 1]);
+        for (; i + 15 <= last; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(bytes + i));
+            __m128i z = _mm_loadu_si128((const __m128i*)(bytes + i + n - 1));
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(a, head), _mm_cmpeq_epi8(z, tail)));
+            for (; mask; mask &= mask - 1) {
+                int k = i + __builtin_ctz(mask);
+                if (sameBytes(bytes + k + 1, s + 1, n - 2)) return k;
+            }
+        }
+#endif
+        for (; i <= last; ++i)
+            if (bytes[i] == s[0] && bytes[i + n - 1] == s[n - 1] && sameBytes(bytes + i + 1, s + 1, n - 2)) return i;
+        return -1;
+    }
+
+    // start and end (offset of the terminator) of the name holding byte off
+    int nameStart(int off) const { while (off > 0 && bytes[off - 1] != '\0') --off; return off; }
+    int nameEnd(int off) const { while (bytes[off] != '\0') ++off; return off; }
+
+private:
+    static bool sameBytes(const char* a, const char* b, int n) {
+        for (int i = 0; i < n; ++i) if (a[i] != b[i]) return false;
+        return true;
+    }
+};
+
+// -------------------------
+// Class: FamilyMember
+// -------------------------
+class FamilyMember {
+private:
+    const NamePool* names; // owner of the name bytes
+    int nameOffset;
+    int nameLen;
+    char gender; // 'M' or 'F'
+    bool alive;
+
+    FamilyMember* father;
+    FamilyMember* mother;
+    FamilyMember* firstChild;
+    FamilyMember* lastChild;   // tail of the firstChild/nextSibling chain (O(1) append)
+    FamilyMember* nextSibling;
+    FamilyMember* prevSibling; // back link of the same chain (O(1) unlink)
+    int childCount;            // length of that chain
+
+    unsigned int visitMark;    // renderer's per-generation dedup stamp (see FamilyTree::nextVisitEpoch)
+
+    unsigned int nameHash; // cached hashName(name), used by FamilyTree's name index
+    int poolIndex;         // position in FamilyTree::memberPool (-1 until pooled)
+
+    void init(char g, bool isAlive) {
+        nameHash = hashName(names->text(nameOffset), nameLen);
+        gender = (g == 'M' || g == 'm') ? 'M' : 'F';
+        alive = isAlive;
+        father = mother = firstChild = lastChild = nextSibling = prevSibling = NULL;
+        childCount = 0;
+        visitMark = 0;
+        poolIndex = -1;
+    }
+
+public:
+    // interns n (truncated to NamePool::MAX_LEN chars) into pool
+    FamilyMember(NamePool& pool, const char* n, char g, bool isAlive) {
+        names = &pool;
+        nameLen = nameLength(n);
+        nameOffset = pool.add(n, nameLen);
+        init(g, isAlive);
+    }
+
+    // name already stored in pool at offset (snapshot load)
+    FamilyMember(const NamePool& pool, int offset, int len, char g, bool isAlive) {
+        names = &pool;
+        nameOffset = offset;
+        nameLen = len;
+        init(g, isAlive);
+    }
+
+    // stored length of s: up to the terminator, at most NamePool::MAX_LEN
+    static int nameLength(const char* s) {
+        int n = 0;
+        while (n < NamePool::MAX_LEN && s[n] != '\0') ++n;
+        return n;
+    }
+
+    // FNV-1a over the name bytes (terminator excluded)
+    static unsigned int hashName(const char* s, int n) {
+        unsigned int h = 2166136261u;
+        for (int i = 0; i < n; ++i) { h ^= (unsigned char)s[i]; h *= 16777619u; }
+        return h;
+    }
+
+    // equality against a probe: hash and length first, bytes only when both match
+    bool hasName(const char* s, int n, unsigned int h) const {
+        if (nameHash != h || nameLen != n) return false;
+        const char* t = names->text(nameOffset);
+        for (int i = 0; i < n; ++i) if (t[i] != s[i]) return false;
+        return true;
+    }
+
+    const char* getName() const { return names->text(nameOffset); }
+    int getNameLen() const { return nameLen; }
+    int getNameOffset() const { return nameOffset; }
+    unsigned int getNameHash() const { return nameHash; }
+    char getGender() const { return gender; }
+    bool isAlive() const { return alive; }
+
+    void setAlive(bool a) { alive = a; }
+
+    FamilyMember* getFather() const { return father; }
+    FamilyMember* getMother() const { return mother; }
+    FamilyMember* getFirstChild() const { return firstChild; }
+    FamilyMember* getLastChild() const { return lastChild; }
+    FamilyMember* getNextSibling() const { return nextSibling; }
+    FamilyMember* getPrevSibling() const { return prevSibling; }
+    int getChildCount() const { return childCount; }
+    int getPoolIndex() const { return poolIndex; }
+    void setPoolIndex(int i) { poolIndex = i; }
+
+    void setFather(FamilyMember* f) { father = f; }
+    void setMother(FamilyMember* m) { mother = m; }
+    void setNextSibling(FamilyMember* s) { nextSibling = s; }
+    void setPrevSibling(FamilyMember* s) { prevSibling = s; }
+
+    // stamp the member with epoch; returns false if it already carried that stamp
+    bool markVisited(unsigned int epoch) {
+        if (visitMark == epoch) return false;
+        visitMark = epoch;
+        return true;
+    }
+    void clearVisited() { visitMark = 0; }
+
+    // bulk link restore used when loading a snapshot (bypasses addChild; the loader sets
+    // prevSibling from the next links)
+    void restoreLinks(FamilyMember* f, FamilyMember* m, FamilyMember* first, FamilyMember* last,
+        FamilyMember* next, int count) {
+        father = f; mother = m;
+        firstChild = first; lastChild = last; nextSibling = next;
+        childCount = count;
+    }
+
+    void addChild(FamilyMember* child) {
+        if (!child) return;
+        FT_COUNT(CHILD_LINKS, 1); // O(1) through lastChild, never a sibling walk
+        if (firstChild == NULL) firstChild = child;
+        else lastChild->nextSibling = child;
+        child->prevSibling = lastChild;
+        lastChild = child;
+        ++childCount;
+    }
+
+    // child must be in this member's chain; O(1) through its prevSibling link
+    void removeChild(FamilyMember* child) {
+        FamilyMember* p = child->prevSibling;
+        FamilyMember* n = child->nextSibling;
+        if (p) p->nextSibling = n; else firstChild = n;
+        if (n) n->prevSibling = p; else lastChild = p;
+        child->prevSibling = child->nextSibling = NULL;
+        --childCount;
+    }
+};
+
+// -------------------------
+// Class: FamilyPair (represents parents pair and children list)
+// We'll use a linked list of FamilyPair nodes for dynamic lists
+// -------------------------
+class FamilyPair {
+private:
+    FamilyMember* father;
+    FamilyMember* mother;
+
+    // children in print order: up to 4 inline, larger families grow in the pair's arena
+    SmallArray<FamilyMember*, 4> children;
+
+    FamilyPair* next;
+
+    Arena* arena; // owner of this pair, its children array and its display lines
+
+    // display lines cached by layout() (NULL until then)
+    const char* parentText;
+    const char* childText;
+    int parentLen;
+    int childLen;
+    int width;
+
+    FamilyPair(Arena* a, FamilyMember* f, FamilyMember* m) : children(a) {
+        father = f; mother = m;
+        next = NULL;
+        arena = a;
+        parentText = childText = NULL;
+        parentLen = childLen = width = 0;
+    }
+
+public:
+    // pairs only live in an Arena and are released by Arena::reset()
+    static FamilyPair* create(Arena& a, FamilyMember* f, FamilyMember* m) {
+        FT_COUNT(PAIRS_CREATED, 1);
+        FT_COUNT(PAIR_BYTES, sizeof(FamilyPair));
+        return new (a.alloc(sizeof(FamilyPair))) FamilyPair(&a, f, m);
+    }
+
+    void addChild(FamilyMember* c) {
+        if (!c) return;
+        if (children.full()) FT_COUNT(PAIR_CHILD_GROWS, 1);
+        children.push(c);
+    }
+
+    int getChildCount() const { return children.size(); }
+    FamilyMember* getChild(int i) const { return (i >= 0 && i < children.size()) ? children[i] : NULL; }
+
+    FamilyMember* getFather() const { return father; }
+    FamilyMember* getMother() const { return mother; }
+
+    void setNext(FamilyPair* n) { next = n; }
+    FamilyPair* getNext() const { return next; }
+
+    // convenience: produce display string for parents (truncated to MAX_NAME); returns its length
+    int parentLine(char* out, int outSize) const {
+        // format: FatherName (M) - MotherName (F)
+        const char* fn = father ? father->getName() : "Unknown";
+        const char* mn = mother ? mother->getName() : "Unknown";
+
+        // truncated name lengths (known up front, no terminator scan)
+        int fl = father ? father->getNameLen() : 7;
+        int ml = mother ? mother->getNameLen() : 7;
+        if (fl > MAX_NAME) fl = MAX_NAME;
+        if (ml > MAX_NAME) ml = MAX_NAME;
+
+        // gender display
+        char fg = father ? father->getGender() : 'M';
+        char mg = mother ? mother->getGender() : 'F';
+
+        // compose (safe)
+        int p = 0;
+        int k = 0;
+        // father
+        while (k < fl && p < outSize - 1) out[p++] = fn[k++];
+        out[p] = '\0';
+        if (p < outSize - 1) { out[p++] = ' '; out[p++] = '('; out[p++] = fg; out[p++] = ')'; }
+        // separator
+        if (p < outSize - 1) { out[p++] = ' '; out[p++] = '-'; out[p++] = ' '; }
+        // mother
+        k = 0;
+        while (k < ml && p < outSize - 1) out[p++] = mn[k++];
+        out[p] = '\0';
+        if (p < outSize - 1) { out[p++] = ' '; out[p++] = '('; out[p++] = mg; out[p++] = ')'; }
+        p = (p < outSize) ? p : outSize - 1;
+        out[p] = '\0';
+        return p;
+    }
+
+    // children line (concatenate child names separated by spaces, truncated); returns its length
+    int childrenLine(char* out, int outSize) const {
+        int p = 0;
+        for (int i = 0; i < children.size(); ++i) {
+            const char* cn = children[i]->getName();
+            // truncated name
+            int n = children[i]->getNameLen();
+            if (n > MAX_NAME) n = MAX_NAME;
+            for (int c = 0; c < n && p < outSize - 1; ++c) out[p++] = cn[c];
+            if (i != children.size() - 1 && p < outSize - 1) out[p++] = ' ';
+        }
+        out[p] = '\0';
+        return p;
+    }
+
+    static const int PARENT_TEXT = 2 * MAX_NAME + 12; // "name (g) - name (g)" always fits
+
+    int childTextSize() const {
+        int cSize = children.size() * (MAX_NAME + 1) + 1;
+        return cSize > LINE_BUF ? LINE_BUF : cSize;
+    }
+
+    // layout in two steps: reserveLayout() takes the line buffers from the arena (not
+    // thread-safe), format() only writes this pair's own buffers and fields, so the pairs of
+    // one generation may be formatted concurrently
+    void reserveLayout() {
+        parentText = (const char*)arena->alloc(PARENT_TEXT);
+        childText = (const char*)arena->alloc(childTextSize());
+    }
+
+    // fill the reserved lines and cache their lengths and block width
+    void format() {
+        parentLen = parentLine((char*)parentText, PARENT_TEXT);
+        childLen = childrenLine((char*)childText, childTextSize());
+        width = parentLen > childLen ? parentLen : childLen;
+        if (width < 6) width = 6; // minimal width for neatness
+    }
+
+    // build both display lines in the pair's arena and cache their lengths and block width
+    void layout() { reserveLayout(); format(); }
+
+    const char* getParentText() const { return parentText; }
+    const char* getChildText() const { return childText; }
+    int getParentLen() const { return parentLen; }
+    int getChildLen() const { return childLen; }
+    int getWidth() const { return width; }
+};
+
+// -------------------------
+// Class: NameIndex (open-addressing hash table: name -> member)
+// Linear probing over a power-of-two slot array; members carry their own hash.
+// -------------------------
+class NameIndex {
+private:
+    FamilyMember** slots;
+    int cap;    // always 0 or a power of two
+    int used;
+
+    void place(FamilyMember* m) {
+        int mask = cap - 1;
+        int i = (int)(m->getNameHash() & (unsigned int)mask);
+        while (slots[i]) i = (i + 1) & mask;
+        slots[i] = m;
+    }
+
+    void grow() {
+        int oldCap = cap;
+        FamilyMember** old = slots;
+        cap = oldCap ? oldCap * 2 : 16;
+        slots = new FamilyMember * [cap];
+        for (int i = 0; i < cap; ++i) slots[i] = NULL;
+        for (int i = 0; i < oldCap; ++i) if (old[i]) place(old[i]);
+        if (old) delete[] old;
+    }
+
+public:
+    NameIndex() { slots = NULL; cap = used = 0; }
+    ~NameIndex() { if (slots) delete[] slots; }
+
+    FamilyMember* find(const char* name, int len, unsigned int h) const {
+        if (used == 0) return NULL;
+        int mask = cap - 1;
+        int i = (int)(h & (unsigned int)mask);
+        while (slots[i]) {
+            FT_COUNT(NAME_PROBES, 1);
+            if (slots[i]->hasName(name, len, h)) return slots[i];
+            i = (i + 1) & mask;
+        }
+        return NULL;
+    }
+
+    // pre-size for n names so bulk loads never rehash
+    void reserve(int n) {
+        while (n * 4 > cap * 3) grow();
+    }
+
+    // keeps the first member registered under a name, like the old pool scan did
+    void insert(FamilyMember* m) {
+        if (find(m->getName(), m->getNameLen(), m->getNameHash())) return;
+        if ((used + 1) * 4 > cap * 3) grow(); // load factor <= 0.75
+        place(m);
+        ++used;
+    }
+
+    // Drops m if it is the member indexed under its name; returns whether it was. Later
+    // entries of the probe run are shifted back into the gap (no tombstones), so lookups
+    // stay as short as if m had never been inserted.
+    bool remove(const FamilyMember* m) {
+        if (used == 0) return false;
+        int mask = cap - 1;
+        int i = (int)(m->getNameHash() & (unsigned int)mask);
+        while (slots[i] && slots[i] != m) i = (i + 1) & mask;
+        if (!slots[i]) return false;
+        slots[i] = NULL;
+        --used;
+        for (int j = (i + 1) & mask; slots[j]; j = (j + 1) & mask) {
+            int home = (int)(slots[j]->getNameHash() & (unsigned int)mask);
+            // slots[j] may move into the gap unless its home lies cyclically in (i, j]
+            bool stays = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+            if (stays) continue;
+            slots[i] = slots[j];
+            slots[j] = NULL;
+            i = j;
+        }
+        return true;
+    }
+};
+
+// -------------------------
+// Class: NameTrie (radix trie over the name pool: alphabetical order and prefix queries)
+// Node arrays indexed by node id (node 0 is the empty root). Every edge label is a slice
+// of a name already in the NamePool, so the trie stores no characters of its own. Children
+// are kept sorted by first byte and every node counts the members below it, so a prefix
+// query walks k bytes down and a page is reached by skipping whole subtrees.
+// -------------------------
+class NameTrie {
+private:
+    int* labelOff;   // label = names[labelOff .. labelOff + labelLen)
+    int* labelLen;
+    int* firstChild;
+    int* nextSibling;
+    int* member;     // first member with exactly this name, NONE if none
+    int* count;      // members in this subtree
+    int nodes;
+    int nodeCap;
+    int* sameName;   // per member: next member with the same name (chained in insertion order)
+    int memberCap;
+
+    static int* growInts(int* old, int n, int nc) {
+        int* tmp = new int[nc];
+        for (int i = 0; i < n; ++i) tmp[i] = old[i];
+        if (old) delete[] old;
+        return tmp;
+    }
+
+    int newNode(int off, int len, int first, int m, int c) {
+        if (nodes >= nodeCap) {
+            int nc = nodeCap ? nodeCap * 2 : 64;
+            labelOff = growInts(labelOff, nodes, nc);
+            labelLen = growInts(labelLen, nodes, nc);
+            firstChild = growInts(firstChild, nodes, nc);
+            nextSibling = growInts(nextSibling, nodes, nc);
+            member = growInts(member, nodes, nc);
+            count = growInts(count, nodes, nc);
+            nodeCap = nc;
+        }
+        labelOff[nodes] = off; labelLen[nodes] = len;
+        firstChild[nodes] = first; nextSibling[nodes] = NONE;
+        member[nodes] = m; count[nodes] = c;
+        return nodes++;
+    }
+
+    // child of node whose label starts with byte c; prev gets the sorted insertion point
+    int childFor(const char* b, int node, unsigned char c, int& prev) const {
+        prev = NONE;
+        for (int k = firstChild[node]; k != NONE; k = nextSibling[k]) {
+            unsigned char f = (unsigned char)b[labelOff[k]];
+            if (f == c) return k;
+            if (f > c) break;
+            prev = k;
+        }
+        return NONE;
+    }
+
+    // node whose subtree holds exactly the names starting with p[0..k), NONE if none
+    int locate(const NamePool& names, const char* p, int k) const {
+        if (nodes == 0) return NONE;
+        const char* b = names.data();
+        int node = 0, pos = 0, prev;
+        while (pos < k) {
+            node = childFor(b, node, (unsigned char)p[pos], prev);
+            if (node == NONE) return NONE;
+            const char* l = b + labelOff[node];
+            for (int i = 0; i < labelLen[node] && pos < k; ++i, ++pos) if (l[i] != p[pos]) return NONE;
+        }
+        return node;
+    }
+
+    // node ending exactly at the name s[0..len), NONE if there is none; path receives the
+    // nodes from the root down to it and depth their number
+    int exact(const char* b, const char* s, int len, int* path, int& depth) const {
+        depth = 0;
+        if (nodes == 0) return NONE;
+        int node = 0, pos = 0, prev;
+        path[depth++] = 0;
+        while (pos < len) {
+            node = childFor(b, node, (unsigned char)s[pos], prev);
+            if (node == NONE || labelLen[node] > len - pos) return NONE;
+            const char* l = b + labelOff[node];
+            for (int i = 0; i < labelLen[node]; ++i) if (l[i] != s[pos + i]) return NONE;
+            pos += labelLen[node];
+            path[depth++] = node;
+        }
+        return node;
+    }
+
+public:
+    static const int NONE = -1;
+
+    NameTrie() {
+        labelOff = labelLen = firstChild = nextSibling = member = count = sameName = NULL;
+        nodes = nodeCap = memberCap = 0;
+    }
+    ~NameTrie() {
+        if (nodeCap) { delete[] labelOff; delete[] labelLen; delete[] firstChild; delete[] nextSibling; delete[] member; delete[] count; }
+        if (sameName) delete[] sameName;
+    }
+
+    void reserve(int n) {
+        if (n <= memberCap) return;
+        sameName = growInts(sameName, memberCap, n);
+        memberCap = n;
+    }
+
+    // register member m (pool index, not registered yet) named names[off .. off + len)
+    void insert(const NamePool& names, int off, int len, int m) {
+        if (m >= memberCap) {
+            int nc = memberCap ? memberCap * 2 : 16;
+            while (nc <= m) nc *= 2;
+            reserve(nc);
+        }
+        sameName[m] = NONE;
+        if (nodes == 0) newNode(0, 0, NONE, NONE, 0);
+        const char* b = names.data();
+        const char* s = b + off;
+        int path[NamePool::MAX_LEN + 2]; // every level consumes at least one byte
+        int depth = 0, node = 0, pos = 0;
+        while (true) {
+            path[depth++] = node;
+            if (pos == len) {
+                if (member[node] == NONE) member[node] = m;
+                else { // same name as an earlier member: append to its chain
+                    int t = member[node];
+                    while (sameName[t] != NONE) t = sameName[t];
+                    sameName[t] = m;
+                }
+                break;
+            }
+            int prev;
+            int k = childFor(b, node, (unsigned char)s[pos], prev);
+            if (k == NONE) { // new leaf labelled with the rest of the name
+                int leaf = newNode(off + pos, len - pos, NONE, m, 0);
+                if (prev == NONE) { nextSibling[leaf] = firstChild[node]; firstChild[node] = leaf; }
+                else { nextSibling[leaf] = nextSibling[prev]; nextSibling[prev] = leaf; }
+                path[depth++] = leaf;
+                break;
+            }
+            const char* l = b + labelOff[k];
+            int common = 1;
+            while (common < labelLen[k] && pos + common < len && l[common] == s[pos + common]) ++common;
+            if (common < labelLen[k]) { // split k: the shared part becomes a new parent
+                int mid = newNode(labelOff[k], common, k, NONE, count[k]);
+                nextSibling[mid] = nextSibling[k];
+                if (prev == NONE) firstChild[node] = mid; else nextSibling[prev] = mid;
+                nextSibling[k] = NONE;
+                labelOff[k] += common;
+                labelLen[k] -= common;
+                k = mid;
+            }
+            node = k;
+            pos += common;
+        }
+        for (int i = 0; i < depth; ++i) ++count[path[i]];
+    }
+
+    // Unregister member m named names[off .. off + len). Counts on its path drop by one;
+    // nodes left empty stay in place (pages skip them) and are reused if the name returns.
+    void remove(const NamePool& names, int off, int len, int m) {
+        int path[NamePool::MAX_LEN + 2];
+        int depth;
+        const char* b = names.data();
+        int node = exact(b, b + off, len, path, depth);
+        if (node == NONE) return;
+        if (member[node] == m) member[node] = sameName[m];
+        else {
+            int t = member[node];
+            while (t != NONE && sameName[t] != m) t = sameName[t];
+            if (t == NONE) return;
+            sameName[t] = sameName[m];
+        }
+        for (int i = 0; i < depth; ++i) --count[path[i]];
+    }
+
+    // member m named names[off .. off + len) now has pool index to (swap-remove in the pool)
+    void renumber(const NamePool& names, int off, int len, int m, int to) {
+        int path[NamePool::MAX_LEN + 2];
+        int depth;
+        const char* b = names.data();
+        int node = exact(b, b + off, len, path, depth);
+        if (node == NONE) return;
+        if (member[node] == m) member[node] = to;
+        else {
+            int t = member[node];
+            while (t != NONE && sameName[t] != m) t = sameName[t];
+            if (t == NONE) return;
+            sameName[t] = to;
+        }
+        sameName[to] = sameName[m];
+    }
+
+    // first member (pool index) named s[0..len), NONE if nobody has that name
+    int first(const NamePool& names, const char* s, int len) const {
+        int path[NamePool::MAX_LEN + 2];
+        int depth;
+        int node = exact(names.data(), s, len, path, depth);
+        return node == NONE ? NONE : member[node];
+    }
+
+    // number of members whose name starts with p[0..k) (k = 0: everyone)
+    int countPrefix(const NamePool& names, const char* p, int k) const {
+        int node = locate(names, p, k);
+        return node == NONE ? 0 : count[node];
+    }
+
+    // Members whose name starts with p[0..k), in byte order (same names in insertion order):
+    // skips the first skip matches, writes at most max pool indices to out, returns how many.
+    int page(const NamePool& names, const char* p, int k, int skip, int max, int* out) const {
+        int top = locate(names, p, k);
+        if (top == NONE || count[top] <= skip || max <= 0) return 0;
+        int stack[NamePool::MAX_LEN + 2];
+        int depth = 0, found = 0, cur = top;
+        while (found < max) {
+            if (cur == NONE) { // children done: continue with the parent's next sibling
+                if (depth == 0) break;
+                cur = nextSibling[stack[--depth]];
+                if (depth == 0) break; // never leave the prefix subtree
+                continue;
+            }
+            if (count[cur] <= skip) { skip -= count[cur]; cur = nextSibling[cur]; continue; }
+            for (int t = member[cur]; t != NONE && found < max; t = sameName[t]) {
+                if (skip > 0) --skip; else out[found++] = t;
+            }
+            stack[depth++] = cur;
+            cur = firstChild[cur];
+        }
+        return found;
+    }
+};
+
+// -------------------------
+// Class: MemberTopology (structure-of-arrays mirror of the member links)
+// Dense int arrays indexed by pool index (NONE = no link) plus one flag byte per
+// member. Walks that only follow father/mother/child/sibling links use these and
+// never pull FamilyMember's name bytes into cache. FamilyTree updates it on every
+// mutation, so FamilyMember stays the accessor API over the same data.
+// A child is listed (firstChild/nextSibling) under one parent only, its father when it has
+// one. Children with both parents are also chained under their mother (the co-child list),
+// so every child of a member can be reached from it when the member is removed or moved.
+// -------------------------
+class MemberTopology {
+private:
+    int* father;
+    int* mother;
+    int* firstChild;
+    int* nextSibling;
+    int* depth;            // generation depth: 0 without parents, else 1 + deepest parent
+    int* firstCoChild;     // children listed under their father, chained under this mother
+    int* nextCoChild;
+    int* prevCoChild;
+    unsigned char* flags;
+    int count;
+    int cap;
+
+    static int* growInts(int* old, int n, int nc) {
+        int* tmp = new int[nc];
+        for (int i = 0; i < n; ++i) tmp[i] = old[i];
+        if (old) delete[] old;
+        return tmp;
+    }
+
+public:
+    static const int NONE = -1;
+    static const unsigned char MALE = 1, ALIVE = 2;
+
+    MemberTopology() {
+        father = mother = firstChild = nextSibling = depth = firstCoChild = nextCoChild = prevCoChild = NULL;
+        flags = NULL;
+        count = cap = 0;
+    }
+    ~MemberTopology() {
+        if (cap) {
+            delete[] father; delete[] mother; delete[] firstChild; delete[] nextSibling; delete[] depth;
+            delete[] firstCoChild; delete[] nextCoChild; delete[] prevCoChild; delete[] flags;
+        }
+    }
+
+    void reserve(int n) {
+        if (n <= cap) return;
+        father = growInts(father, count, n);
+        mother = growInts(mother, count, n);
+        firstChild = growInts(firstChild, count, n);
+        nextSibling = growInts(nextSibling, count, n);
+        depth = growInts(depth, count, n);
+        firstCoChild = growInts(firstCoChild, count, n);
+        nextCoChild = growInts(nextCoChild, count, n);
+        prevCoChild = growInts(prevCoChild, count, n);
+        unsigned char* tf = new unsigned char[n];
+        for (int i = 0; i < count; ++i) tf[i] = flags[i];
+        if (flags) delete[] flags;
+        flags = tf;
+        cap = n;
+    }
+
+    // new unlinked member at the next index
+    int append(bool male, bool alive) {
+        if (count >= cap) reserve(cap ? cap * 2 : 8);
+        father[count] = mother[count] = firstChild[count] = nextSibling[count] = NONE;
+        firstCoChild[count] = nextCoChild[count] = prevCoChild[count] = NONE;
+        depth[count] = 0;
+        flags[count] = (unsigned char)((male ? MALE : 0) | (alive ? ALIVE : 0));
+        return count++;
+    }
+
+    int size() const { return count; }
+    int getFather(int i) const { return father[i]; }
+    int getMother(int i) const { return mother[i]; }
+    int getFirstChild(int i) const { return firstChild[i]; }
+    int getNextSibling(int i) const { return nextSibling[i]; }
+    int getDepth(int i) const { return depth[i]; }
+    int getFirstCoChild(int i) const { return firstCoChild[i]; }
+    int getNextCoChild(int i) const { return nextCoChild[i]; }
+    bool isMale(int i) const { return (flags[i] & MALE) != 0; }
+    bool isAlive(int i) const { return (flags[i] & ALIVE) != 0; }
+
+    // also moves i between co-child lists (O(1) either way)
+    void setParents(int i, int f, int m) {
+        if (father[i] != NONE && mother[i] != NONE && father[i] != mother[i]) {
+            int p = prevCoChild[i], n = nextCoChild[i];
+            if (p != NONE) nextCoChild[p] = n; else firstCoChild[mother[i]] = n;
+            if (n != NONE) prevCoChild[n] = p;
+            nextCoChild[i] = prevCoChild[i] = NONE;
+        }
+        father[i] = f; mother[i] = m;
+        if (f != NONE && m != NONE && f != m) {
+            nextCoChild[i] = firstCoChild[m];
+            if (firstCoChild[m] != NONE) prevCoChild[firstCoChild[m]] = i;
+            firstCoChild[m] = i;
+        }
+    }
+    void setFirstChild(int i, int c) { firstChild[i] = c; }
+    void setNextSibling(int i, int s) { nextSibling[i] = s; }
+    void setAlive(int i, bool a) { flags[i] = (unsigned char)(a ? (flags[i] | ALIVE) : (flags[i] & ~ALIVE)); }
+
+    // Swap-remove: the last entry takes index to, whose member must already be unlinked. Its
+    // children's parent links and its co-child neighbours are renumbered here; the link from
+    // the chain it is listed in (previous sibling or list head) is the caller's, who has the
+    // back pointers. Returns the index the moved entry had.
+    int removeByMove(int to) {
+        int from = --count;
+        if (from == to) return from;
+        father[to] = father[from]; mother[to] = mother[from];
+        firstChild[to] = firstChild[from]; nextSibling[to] = nextSibling[from];
+        firstCoChild[to] = firstCoChild[from];
+        nextCoChild[to] = nextCoChild[from]; prevCoChild[to] = prevCoChild[from];
+        depth[to] = depth[from];
+        flags[to] = flags[from];
+        for (int c = firstChild[to]; c != NONE; c = nextSibling[c]) {
+            if (father[c] == from) father[c] = to;
+            if (mother[c] == from) mother[c] = to;
+        }
+        for (int c = firstCoChild[to]; c != NONE; c = nextCoChild[c]) mother[c] = to;
+        if (prevCoChild[to] != NONE) nextCoChild[prevCoChild[to]] = to;
+        else if (father[to] != NONE && mother[to] != NONE && father[to] != mother[to]) firstCoChild[mother[to]] = to;
+        if (nextCoChild[to] != NONE) prevCoChild[nextCoChild[to]] = to;
+        return from;
+    }
+
+    // depth of i from its parents' depths (valid when the parents' depths are)
+    void updateDepth(int i) {
+        int d = 0;
+        if (father[i] != NONE) d = depth[father[i]] + 1;
+        if (mother[i] != NONE && depth[mother[i]] + 1 > d) d = depth[mother[i]] + 1;
+        depth[i] = d;
+    }
+
+    // recompute every depth in one pass: iterative post-order over parent links, so each
+    // member is finished after both of its parents. A link that closes a loop (possible in
+    // a hand-edited snapshot) is treated as absent rather than recursed into.
+    void recomputeDepths() {
+        char* color = new char[count > 0 ? count : 1]; // 0 new, 1 on stack, 2 done
+        int* stack = new int[count > 0 ? count : 1];
+        char* edge = new char[count > 0 ? count : 1];  // next parent slot per stack entry
+        for (int i = 0; i < count; ++i) color[i] = 0;
+        for (int i = 0; i < count; ++i) {
+            if (color[i]) continue;
+            int sp = 0;
+            stack[sp] = i; edge[sp] = 0; color[i] = 1; ++sp;
+            while (sp > 0) {
+                int mi = stack[sp - 1];
+                if (edge[sp - 1] == 2) {
+                    int d = 0;
+                    if (father[mi] != NONE && color[father[mi]] == 2) d = depth[father[mi]] + 1;
+                    if (mother[mi] != NONE && color[mother[mi]] == 2 && depth[mother[mi]] + 1 > d) d = depth[mother[mi]] + 1;
+                    depth[mi] = d;
+                    color[mi] = 2;
+                    --sp;
+                    continue;
+                }
+                int pi = edge[sp - 1]++ == 0 ? father[mi] : mother[mi];
+                if (pi != NONE && color[pi] == 0) {
+                    color[pi] = 1; stack[sp] = pi; edge[sp] = 0; ++sp;
+                }
+            }
+        }
+        delete[] color; delete[] stack; delete[] edge;
+    }
+};
+
+// -------------------------
+// Class: LineageIndex (ancestor / descendant / relationship queries over MemberTopology)
+// Children are listed per parent in compressed rows (both father and mother see
+// the child, unlike the render child lists, which only hang a child under one of
+// them). The rows are rebuilt lazily after links change; upward walks only need
+// the parent links, so they keep working while the rows are stale and only grow
+// their scratch as members are appended. Walks use epoch stamps so no per-query
+// clearing is needed. Results are pool indices.
+// -------------------------
+class LineageIndex {
+private:
+    int* rowStart;  // children of i are kids[rowStart[i] .. rowStart[i + 1])
+    int* kids;
+    int rowCap;
+    bool stale;
+
+    unsigned int* mark;   // walk stamps
+    unsigned int* markX;  // relate(): stamps of x's ancestor set
+    int* upX;             // relate(): x's distance to each stamped ancestor
+    int* queue;
+    int* dist;
+    unsigned int epoch;
+    int cap;
+
+    unsigned int nextEpoch() {
+        if (++epoch == 0) {
+            for (int i = 0; i < cap; ++i) mark[i] = markX[i] = 0;
+            epoch = 1;
+        }
+        return epoch;
+    }
+
+    static void growTo(int*& a, int n, int nc) {
+        int* tmp = new int[nc];
+        for (int i = 0; i < n; ++i) tmp[i] = a[i];
+        if (a) delete[] a;
+        a = tmp;
+    }
+    static void growTo(unsigned int*& a, int n, int nc) {
+        unsigned int* tmp = new unsigned int[nc];
+        for (int i = 0; i < n; ++i) tmp[i] = a[i];
+        for (int i = n; i < nc; ++i) tmp[i] = 0;
+        if (a) delete[] a;
+        a = tmp;
+    }
+
+public:
+    LineageIndex() {
+        rowStart = kids = queue = dist = upX = NULL;
+        mark = markX = NULL;
+        rowCap = cap = 0;
+        epoch = 0;
+        stale = true;
+    }
+    ~LineageIndex() {
+        if (rowCap) { delete[] rowStart; delete[] kids; }
+        if (cap) { delete[] mark; delete[] markX; delete[] upX; delete[] queue; delete[] dist; }
+    }
+
+    void invalidate() { stale = true; }
+    bool isStale() const { return stale; }
+    // the rows (fresh index only): children of i are rowKids()[rowStarts()[i] .. rowStarts()[i + 1])
+    const int* rowStarts() const { return rowStart; }
+    const int* rowKids() const { return kids; }
+
+    // walk scratch for n members; stamps survive growth, so appends never force a clear
+    void reserve(int n) {
+        if (n <= cap) return;
+        int nc = cap ? cap : 8;
+        while (nc < n) nc *= 2;
+        growTo(mark, cap, nc);
+        growTo(markX, cap, nc);
+        growTo(upX, 0, nc);
+        growTo(queue, 0, nc);
+        growTo(dist, 0, nc);
+        cap = nc;
+    }
+
+    void rebuild(const MemberTopology& t) {
+        int count = t.size();
+        reserve(count);
+        if (count > rowCap) {
+            if (rowCap) { delete[] rowStart; delete[] kids; }
+            rowCap = cap;
+            rowStart = new int[rowCap + 1];
+            kids = new int[2 * rowCap];
+        }
+        for (int i = 0; i <= count; ++i) rowStart[i] = 0;
+        for (int i = 0; i < count; ++i) {
+            int f = t.getFather(i), m = t.getMother(i);
+            if (f != MemberTopology::NONE) ++rowStart[f + 1];
+            if (m != MemberTopology::NONE && m != f) ++rowStart[m + 1];
+        }
+        for (int i = 0; i < count; ++i) rowStart[i + 1] += rowStart[i];
+        int* fill = queue; // scratch: next free slot per row
+        for (int i = 0; i < count; ++i) fill[i] = rowStart[i];
+        for (int i = 0; i < count; ++i) { // ascending i keeps each row in pool order
+            int f = t.getFather(i), m = t.getMother(i);
+            if (f != MemberTopology::NONE) kids[fill[f]++] = i;
+            if (m != MemberTopology::NONE && m != f) kids[fill[m]++] = i;
+        }
+        stale = false;
+    }
+
+    // breadth-first over parent links: nearest generation first, each ancestor once with
+    // its shortest distance; maxGen = 0 means no limit. Returns the number written to out.
+    int ancestors(const MemberTopology& t, int i, int maxGen, int* out, int* gens) {
+        unsigned int e = nextEpoch();
+        int head = 0, tail = 0, n = 0;
+        mark[i] = e; queue[tail] = i; dist[tail++] = 0;
+        while (head < tail) {
+            int c = queue[head], d = dist[head++];
+            if (maxGen > 0 && d >= maxGen) continue;
+            int p[2] = { t.getFather(c), t.getMother(c) };
+            for (int k = 0; k < 2; ++k) {
+                if (p[k] == MemberTopology::NONE || mark[p[k]] == e) continue;
+                mark[p[k]] = e;
+                queue[tail] = p[k]; dist[tail++] = d + 1;
+                out[n] = p[k]; if (gens) gens[n] = d + 1; ++n;
+            }
+        }
+        return n;
+    }
+
+    // same over the child rows (requires a fresh index)
+    int descendants(int i, int maxGen, int* out, int* gens) {
+        unsigned int e = nextEpoch();
+        int head = 0, tail = 0, n = 0;
+        mark[i] = e; queue[tail] = i; dist[tail++] = 0;
+        while (head < tail) {
+            int c = queue[head], d = dist[head++];
+            if (maxGen > 0 && d >= maxGen) continue;
+            for (int k = rowStart[c]; k < rowStart[c + 1]; ++k) {
+                int ch = kids[k];
+                if (mark[ch] == e) continue;
+                mark[ch] = e;
+                queue[tail] = ch; dist[tail++] = d + 1;
+                out[n] = ch; if (gens) gens[n] = d + 1; ++n;
+            }
+        }
+        return n;
+    }
+
+    // upward search from d that never enters members at or above a's depth, so only the
+    // band of generations between the two is visited (requires valid depths)
+    bool isAncestor(const MemberTopology& t, int a, int d) {
+        int da = t.getDepth(a);
+        if (a == d || t.getDepth(d) <= da) return false;
+        unsigned int e = nextEpoch();
+        int sp = 0;
+        mark[d] = e; queue[sp++] = d;
+        while (sp > 0) {
+            int c = queue[--sp];
+            int p[2] = { t.getFather(c), t.getMother(c) };
+            for (int k = 0; k < 2; ++k) {
+                if (p[k] == a) return true;
+                if (p[k] == MemberTopology::NONE || mark[p[k]] == e || t.getDepth(p[k]) <= da) continue;
+                mark[p[k]] = e;
+                queue[sp++] = p[k];
+            }
+        }
+        return false;
+    }
+
+    // Closest common ancestor of x and y (either may be the ancestor itself). With two
+    // parents per member there is no single lowest common ancestor, so the one with the
+    // smallest upX + upY is taken, ties going to the one nearer to x. shared counts how many
+    // common ancestors reach that same (upX, upY): 2 for a couple (full relation), 1 for a
+    // single shared parent line (half relation). Returns NONE if x and y are unrelated.
+    // Both walks are breadth-first and y's stops once it cannot improve on the best sum.
+    int relate(const MemberTopology& t, int x, int y, int& ux, int& uy, int& shared) {
+        unsigned int ex = nextEpoch();
+        unsigned int ey = nextEpoch(); // both up front: a wrap in between would wipe x's stamps
+        int head = 0, tail = 0;
+        markX[x] = ex; upX[x] = 0; queue[tail++] = x;
+        while (head < tail) {
+            int c = queue[head++];
+            int p[2] = { t.getFather(c), t.getMother(c) };
+            for (int k = 0; k < 2; ++k) {
+                if (p[k] == MemberTopology::NONE || markX[p[k]] == ex) continue;
+                markX[p[k]] = ex; upX[p[k]] = upX[c] + 1;
+                queue[tail++] = p[k];
+            }
+        }
+
+        int best = MemberTopology::NONE, bestSum = 0;
+        ux = uy = shared = 0;
+        head = tail = 0;
+        mark[y] = ey; queue[tail] = y; dist[tail++] = 0;
+        while (head < tail) {
+            int c = queue[head], d = dist[head++];
+            if (best != MemberTopology::NONE && d > bestSum) break;
+            if (markX[c] == ex) {
+                int sum = upX[c] + d;
+                if (best == MemberTopology::NONE || sum < bestSum || (sum == bestSum && upX[c] < ux)) {
+                    best = c; bestSum = sum; ux = upX[c]; uy = d; shared = 1;
+                }
+                else if (upX[c] == ux && d == uy) ++shared;
+                continue; // ancestors above a common ancestor are only farther
+            }
+            int p[2] = { t.getFather(c), t.getMother(c) };
+            for (int k = 0; k < 2; ++k) {
+                if (p[k] == MemberTopology::NONE || mark[p[k]] == ey) continue;
+                mark[p[k]] = ey;
+                queue[tail] = p[k]; dist[tail++] = d + 1;
+            }
+        }
+        return best;
+    }
+};
+
+// -------------------------
+// Class: PairIndex (flat hash map: (father, mother) -> FamilyPair)
+// Slots are stamped with an epoch so clear() is O(1) and the table can be
+// reused for every generation of a render without reallocating.
+// -------------------------
+class PairIndex {
+private:
+    FamilyMember** keyF;
+    FamilyMember** keyM;
+    FamilyPair** vals;
+    unsigned int* stamp;  // slot is live only when stamp[i] == epoch
+    unsigned int epoch;
+    int cap;              // always 0 or a power of two
+    int used;
+
+    static unsigned int hashPair(const FamilyMember* f, const FamilyMember* m) {
+        unsigned long long a = (unsigned long long)(size_t)f;
+        unsigned long long b = (unsigned long long)(size_t)m;
+        unsigned long long h = (a ^ (b * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+        return (unsigned int)(h >> 32);
+    }
+
+    void place(FamilyMember* f, FamilyMember* m, FamilyPair* p) {
+        int mask = cap - 1;
+        int i = (int)(hashPair(f, m) & (unsigned int)mask);
+        while (stamp[i] == epoch) i = (i + 1) & mask;
+        keyF[i] = f; keyM[i] = m; vals[i] = p; stamp[i] = epoch;
+    }
+
+    void grow() {
+        int oldCap = cap;
+        FamilyMember** oF = keyF; FamilyMember** oM = keyM;
+        FamilyPair** oV = vals; unsigned int* oS = stamp;
+        cap = oldCap ? oldCap * 2 : 64;
+        keyF = new FamilyMember * [cap];
+        keyM = new FamilyMember * [cap];
+        vals = new FamilyPair * [cap];
+        stamp = new unsigned int[cap];
+        for (int i = 0; i < cap; ++i) stamp[i] = 0;
+        unsigned int live = epoch;
+        epoch = 1;
+        for (int i = 0; i < oldCap; ++i) if (oS[i] == live) place(oF[i], oM[i], oV[i]);
+        if (oldCap) { delete[] oF; delete[] oM; delete[] oV; delete[] oS; }
+    }
+
+public:
+    PairIndex() { keyF = keyM = NULL; vals = NULL; stamp = NULL; epoch = 1; cap = used = 0; }
+    ~PairIndex() {
+        if (cap) { delete[] keyF; delete[] keyM; delete[] vals; delete[] stamp; }
+    }
+
+    // forget all entries (storage is kept for the next generation)
+    void clear() {
+        used = 0;
+        if (++epoch == 0) { // wrapped: stale stamps could look live again
+            for (int i = 0; i < cap; ++i) stamp[i] = 0;
+            epoch = 1;
+        }
+    }
+
+    FamilyPair* find(FamilyMember* f, FamilyMember* m) const {
+        if (used == 0) return NULL;
+        int mask = cap - 1;
+        int i = (int)(hashPair(f, m) & (unsigned int)mask);
+        while (stamp[i] == epoch) {
+            if (keyF[i] == f && keyM[i] == m) return vals[i];
+            i = (i + 1) & mask;
+        }
+        return NULL;
+    }
+
+    void insert(FamilyMember* f, FamilyMember* m, FamilyPair* p) {
+        if ((used + 1) * 2 > cap) grow(); // load factor <= 0.5
+        place(f, m, p);
+        ++used;
+    }
+};
+
+// -------------------------
+// Class: RenderCache (output of the last showCenteredTree, split by generation)
+// Keeps the rendered text, where each generation's rows start, each generation's
+// distinct children (the seeds the next generation is built from) and, per member,
+// the first generation it was printed in as a child. Mutations mark the first
+// generation they can change; the next render replays the text before it and only
+// rebuilds from there. Seeds point at members, which never move (memberArena).
+// -------------------------
+class RenderCache {
+private:
+    LineBuffer text;
+    int* genStart;     // byte offset of generation g; genStart[genCount] = end of the last one
+    int genCount;
+    int genCap;
+    FamilyMember** seeds; // seeds of generation g: seeds[seedStart[g] .. seedStart[g + 1])
+    int* seedStart;       // genCap + 1 entries
+    int seedGens;         // generations whose seeds are stored
+    int seedCap;
+    int* firstGen;        // per pool index, -1 = not printed
+    int firstGenCap;
+    int limitGens, limitFamilies;
+    int dirtyFrom;
+    bool valid;
+
+    void ensureGens(int n) {
+        if (n < genCap) return;
+        int nc = genCap ? genCap * 2 : 16;
+        while (nc <= n) nc *= 2;
+        int* gs = new int[nc + 1];
+        int* ss = new int[nc + 1];
+        if (genStart) {
+            for (int i = 0; i <= genCount; ++i) gs[i] = genStart[i];
+            for (int i = 0; i <= seedGens; ++i) ss[i] = seedStart[i];
+            delete[] genStart; delete[] seedStart;
+        }
+        genStart = gs; seedStart = ss; genCap = nc;
+    }
+
+public:
+    static const int CLEAN = 0x7FFFFFFF;
+
+    RenderCache() {
+        genStart = seedStart = firstGen = NULL;
+        seeds = NULL;
+        genCount = genCap = seedGens = seedCap = firstGenCap = 0;
+        limitGens = limitFamilies = 0;
+        dirtyFrom = CLEAN;
+        valid = false;
+    }
+    ~RenderCache() {
+        if (genStart) { delete[] genStart; delete[] seedStart; }
+        if (seeds) delete[] seeds;
+        if (firstGen) delete[] firstGen;
+    }
+
+    // cached output exists for these limits (clean or not)
+    bool matches(int gens, int families) const { return valid && gens == limitGens && families == limitFamilies; }
+    bool isClean() const { return dirtyFrom == CLEAN; }
+    // first generation to rebuild: the earliest dirty one that still has the seeds of the one before
+    int restartAt() const { return dirtyFrom < seedGens ? dirtyFrom : seedGens; }
+
+    void invalidate() { valid = false; }
+    void markDirty(int gen) { if (valid && gen < dirtyFrom) dirtyFrom = gen; }
+    int printedIn(int i) const { return valid && i < firstGenCap ? firstGen[i] : -1; }
+
+    // start a full render for members [0, members)
+    void begin(int gens, int families, int members) {
+        text.truncate(0);
+        ensureGens(0);
+        genCount = seedGens = 0;
+        genStart[0] = seedStart[0] = 0;
+        if (members > firstGenCap) {
+            if (firstGen) delete[] firstGen;
+            firstGenCap = members;
+            firstGen = new int[firstGenCap];
+        }
+        for (int i = 0; i < firstGenCap; ++i) firstGen[i] = -1;
+        limitGens = gens; limitFamilies = families;
+        dirtyFrom = CLEAN;
+        valid = true;
+    }
+
+    // drop generation gen and everything after it (also the footer)
+    void truncate(int gen) {
+        text.truncate(genStart[gen]);
+        genCount = gen;
+        if (seedGens > gen) seedGens = gen;
+        dirtyFrom = CLEAN;
+    }
+
+    // text of the generation about to be written starts here; returns its offset
+    int beginGeneration() {
+        ensureGens(genCount + 1);
+        genStart[genCount++] = text.size();
+        return text.size();
+    }
+    void endGenerations() { genStart[genCount] = text.size(); }
+
+    void addSeeds(FamilyMember** list, int n) {
+        ensureGens(seedGens + 1);
+        int base = seedStart[seedGens];
+        if (base + n > seedCap) {
+            int nc = seedCap ? seedCap : 64;
+            while (nc < base + n) nc *= 2;
+            FamilyMember** tmp = new FamilyMember * [nc];
+            for (int i = 0; i < base; ++i) tmp[i] = seeds[i];
+            if (seeds) delete[] seeds;
+            seeds = tmp; seedCap = nc;
+        }
+        for (int i = 0; i < n; ++i) {
+            seeds[base + i] = list[i];
+            notePrinted(list[i]->getPoolIndex(), seedGens);
+        }
+        seedStart[++seedGens] = base + n;
+    }
+
+    FamilyMember** seedsOf(int gen, int& n) const {
+        n = seedStart[gen + 1] - seedStart[gen];
+        return seeds + seedStart[gen];
+    }
+
+    void notePrinted(int i, int gen) {
+        if (i >= firstGenCap) {
+            int nc = firstGenCap ? firstGenCap * 2 : 64;
+            while (nc <= i) nc *= 2;
+            int* tmp = new int[nc];
+            for (int k = 0; k < firstGenCap; ++k) tmp[k] = firstGen[k];
+            for (int k = firstGenCap; k < nc; ++k) tmp[k] = -1;
+            if (firstGen) delete[] firstGen;
+            firstGen = tmp; firstGenCap = nc;
+        }
+        if (firstGen[i] < 0 || gen < firstGen[i]) firstGen[i] = gen;
+    }
+
+    void put(char c) { text.put(c); }
+    void put(const char* s, int n) { text.put(s, n); }
+    LineBuffer& buffer() { return text; } // generation rows are composed straight into the text
+    char* extend(int n) { return text.extend(n); }
+    int size() const { return text.size(); }
+    void writeTo(ostream& os, int from, int to) const {
+        if (to <= from) return;
+        FT_COUNT(RENDER_BYTES, to - from);
+        os.write(text.data() + from, to - from);
+    }
+};
+
+// -------------------------
+// Class: Journal (append-only write-ahead log of tree mutations)
+// Layout (native byte order, 32-bit words):
+//   header : magic "FTJRNL1\0", version, base (member count of the snapshot it follows),
+//            generation (checkpoint number of that snapshot)
+//   records: tag (op | flags << 8 | name length << 16), a, b, c, checksum of the record,
+//            then for CREATE the name bytes padded to a word
+// log() only copies the record into a buffer; a writer thread writes whatever has piled
+// up and syncs it once (group commit), so the caller never waits for the disk.
+// -------------------------
+class Journal {
+private:
+#ifdef FT_POSIX_IO
+    int fd;
+#else
+    ofstream out;
+#endif
+    bool opened;
+    char* fill;       // records logged since the writer last took the buffer
+    int fillLen;
+    int fillCap;
+    char* spare;      // buffer being written by the writer thread
+    int spareCap;
+    unsigned long long logged;  // records handed to log()
+    unsigned long long durable; // records written and synced
+    bool stopping;
+    bool ioFailed;
+    bool writerIdle;  // writer is waiting for records (only then does log() wake it)
+    int syncWaiters;  // callers blocked in sync(): write the batch without waiting for more
+    mutex lock;
+    condition_variable wake;    // writer: new records or stop
+    condition_variable drained; // sync(): a batch became durable
+    thread writer;
+
+    bool writeAll(const char* p, int n) {
+#ifdef FT_POSIX_IO
+        while (n > 0) {
+            ssize_t w = ::write(fd, p, (size_t)n);
+            if (w <= 0) return false;
+            p += w; n -= (int)w;
+        }
+        return ::fsync(fd) == 0;
+#else
+        out.write(p, n);
+        out.flush();
+        return (bool)out;
+#endif
+    }
+
+    void writerLoop() {
+        unique_lock<mutex> g(lock);
+        while (true) {
+            writerIdle = true;
+            wake.wait(g, [&] { return fillLen > 0 || stopping; });
+            writerIdle = false;
+            if (fillLen == 0) break; // stopping with nothing left
+            // group commit: let a burst of records pile up so one sync covers all of them
+            wake.wait_for(g, chrono::milliseconds((long long)GROUP_WINDOW_MS), [&] { return stopping || syncWaiters > 0; });
+            char* t = fill; fill = spare; spare = t;
+            int tc = fillCap; fillCap = spareCap; spareCap = tc;
+            int n = fillLen;
+            fillLen = 0;
+            unsigned long long upto = logged;
+            g.unlock();
+            bool ok = writeAll(spare, n);
+            FT_COUNT(JOURNAL_SYNCS, 1);
+            g.lock();
+            if (!ok) ioFailed = true;
+            durable = upto;
+            drained.notify_all();
+        }
+    }
+
+public:
+    enum Op { CREATE = 1, PARENTS = 2, ATTACH = 3, ALIVE = 4, ROOT = 5, REMOVE = 6, REPARENT = 7 };
+    static const unsigned int NONE = 0xFFFFFFFFu;  // no member (unset parent)
+    static const unsigned int MALE = 1, IS_ALIVE = 2; // CREATE flags
+    static const int HEADER = 20;
+    static const int RECORD = 20;
+    static const unsigned int VERSION = 1;
+    static const int GROUP_WINDOW_MS = 2; // longest a record waits for others to share its sync
+
+    Journal() {
+#ifdef FT_POSIX_IO
+        fd = -1;
+#endif
+        opened = false;
+        fill = spare = NULL;
+        fillLen = fillCap = spareCap = 0;
+        logged = durable = 0;
+        stopping = ioFailed = writerIdle = false;
+        syncWaiters = 0;
+    }
+    ~Journal() {
+        stop();
+        if (fill) delete[] fill;
+        if (spare) delete[] spare;
+    }
+
+    // bytes of the record starting with tag (name included)
+    static int recordSize(unsigned int tag) { return RECORD + (int)(((tag >> 16) + 3u) & ~3u); }
+
+    // FNV-1a over the first four words and the padded name
+    static unsigned int checksum(const char* rec, int size) {
+        unsigned int h = 2166136261u;
+        for (int i = 0; i < size; ++i) {
+            if (i >= 16 && i < RECORD) continue; // the checksum word itself
+            h = (h ^ (unsigned char)rec[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    // Start logging to path. fresh: truncate it and write a header for snapshot generation
+    // of base members; otherwise append to an existing, fully valid journal.
+    bool start(const char* path, unsigned int base, unsigned int generation, bool fresh) {
+        stop();
+#ifdef FT_POSIX_IO
+        fd = ::open(path, O_WRONLY | O_CREAT | (fresh ? O_TRUNC : O_APPEND), 0644);
+        if (fd < 0) return false;
+#else
+        out.open(path, ios::binary | (fresh ? ios::trunc : ios::app));
+        if (!out) return false;
+#endif
+        if (fresh) {
+            char h[HEADER];
+            const char magic[8] = { 'F', 'T', 'J', 'R', 'N', 'L', '1', '\0' };
+            unsigned int w[3] = { VERSION, base, generation };
+            for (int i = 0; i < 8; ++i) h[i] = magic[i];
+            for (int i = 0; i < 12; ++i) h[8 + i] = ((const char*)w)[i];
+            if (!writeAll(h, HEADER)) { opened = true; stop(); return false; }
+        }
+        opened = true;
+        stopping = ioFailed = false;
+        logged = durable = 0;
+        writer = thread(&Journal::writerLoop, this);
+        return true;
+    }
+
+    bool isOpen() const { return opened; }
+
+    void log(int op, unsigned int flags, unsigned int a, unsigned int b, unsigned int c, const char* name = NULL, int len = 0) {
+        unsigned int w[5] = { (unsigned int)op | flags << 8 | (unsigned int)len << 16, a, b, c, 0 };
+        int size = recordSize(w[0]);
+        lock_guard<mutex> g(lock);
+        if (fillLen + size > fillCap) {
+            int nc = fillCap ? fillCap * 2 : 4096;
+            while (nc < fillLen + size) nc *= 2;
+            char* tmp = new char[nc];
+            for (int i = 0; i < fillLen; ++i) tmp[i] = fill[i];
+            if (fill) delete[] fill;
+            fill = tmp;
+            fillCap = nc;
+        }
+        char* r = fill + fillLen;
+        for (int i = 0; i < RECORD; ++i) r[i] = ((const char*)w)[i];
+        for (int i = 0; i < size - RECORD; ++i) r[RECORD + i] = i < len ? name[i] : '\0';
+        w[4] = checksum(r, size);
+        for (int i = 0; i < 4; ++i) r[16 + i] = ((const char*)&w[4])[i];
+        fillLen += size;
+        ++logged;
+        FT_COUNT(JOURNAL_RECORDS, 1);
+        if (writerIdle) wake.notify_one();
+    }
+
+    // block until every record logged so far is on disk; false after a write error
+    bool sync() {
+        if (!opened) return true;
+        unique_lock<mutex> g(lock);
+        unsigned long long want = logged;
+        ++syncWaiters;
+        wake.notify_one();
+        drained.wait(g, [&] { return durable >= want; });
+        --syncWaiters;
+        return !ioFailed;
+    }
+
+    // flush what is left, stop the writer and close the file
+    void stop() {
+        if (!opened) return;
+        {
+            lock_guard<mutex> g(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (writer.joinable()) writer.join();
+#ifdef FT_POSIX_IO
+        ::close(fd);
+        fd = -1;
+#else
+        out.close();
+#endif
+        opened = false;
+    }
+
+    // make a file written through ofstream durable before it replaces an older one
+    static bool syncFile(const char* path) {
+#ifdef FT_POSIX_IO
+        int f = ::open(path, O_RDONLY);
+        if (f < 0) return false;
+        bool ok = ::fsync(f) == 0;
+        ::close(f);
+        return ok;
+#else
+        (void)path;
+        return true;
+#endif
+    }
+};
+
+// -------------------------
+// Class: TreeImage (read-only, pointer-free tree published for other processes)
+// FamilyTree::publishImage writes one file holding the snapshot's member and name tables,
+// the indexes a reader needs (name hash slots, generation depths, child rows under both
+// parents) and the text of the full centered render. Every link is a 32-bit index, so a
+// reader maps the file read-only (mmap MAP_SHARED on POSIX; put it on tmpfs such as
+// /dev/shm for a pure shared-memory segment) and works on it in place: all processes share
+// the same physical pages and nothing is copied or rebuilt. Publishing replaces the file by
+// rename, so readers keep the version they mapped. The only per-process memory is the walk
+// scratch of lineage queries, allocated on first use.
+//   header : magic "FTIMAGE1", version, members, root, nameBytes, slots, kids, textBytes, 0
+//   members: FIELDS words each, as in the snapshot
+//            nameOffset, father, mother, firstChild, lastChild, nextSibling, childCount, flags
+//   depths : one word per member
+//   rows   : members + 1 row starts, then kids child indices (children of i: rows[i] .. rows[i + 1])
+//   slots  : power-of-two table of member indices (NONE = empty), linear probing on
+//            FamilyMember::hashName; a name maps to the member FamilyTree::find returns
+//   names  : nameBytes of NUL-terminated names, then text: textBytes of render output,
+//            each padded to a whole word
+// -------------------------
+class TreeImage {
+private:
+    char* image;   // the mapping (a heap copy where mmap is not available), or borrowed
+    long long bytes;
+    bool borrowed; // attach(): the bytes belong to someone else (a TreeVersion)
+    const unsigned int* rec;
+    const unsigned int* depth;
+    const unsigned int* rows;
+    const unsigned int* kids;
+    const unsigned int* slots;
+    const char* names;
+    const char* text;
+    unsigned int count, rootIdx, nameBytes, slotCount, kidCount, textBytes;
+
+    unsigned int* mark; // lineage walk scratch (per process, first query only)
+    int* queue;
+    int* dist;
+    unsigned int scratchCap;
+    unsigned int epoch;
+
+    static long long padded(long long n) { return (n + 3) & ~3LL; }
+
+    // words from the start of the member table up to the names
+    static long long tableWords(unsigned int members, unsigned int slots, unsigned int kids) {
+        return (long long)members * FIELDS + members + (members + 1LL) + kids + slots;
+    }
+
+    void ensureScratch() {
+        if (scratchCap >= count) return; // kept across attach() of later versions
+        if (mark) { delete[] mark; delete[] queue; delete[] dist; }
+        scratchCap = count;
+        mark = new unsigned int[count];
+        queue = new int[count];
+        dist = new int[count];
+        for (unsigned int i = 0; i < count; ++i) mark[i] = 0;
+        epoch = 0;
+    }
+    unsigned int nextEpoch() {
+        if (++epoch == 0) {
+            for (unsigned int i = 0; i < count; ++i) mark[i] = 0;
+            epoch = 1;
+        }
+        return epoch;
+    }
+
+    // every index in range, every row inside kids and an empty name slot to end probes on;
+    // false for a damaged image
+    bool linksValid() const {
+        for (unsigned int i = 0; i < count; ++i) {
+            const unsigned int* r = rec + (size_t)i * FIELDS;
+            for (int k = 1; k <= 5; ++k) if (r[k] != NONE && r[k] >= count) return false;
+            if (r[0] >= nameBytes) return false;
+            if (rows[i] > rows[i + 1]) return false;
+        }
+        if (rows[0] != 0 || rows[count] != kidCount) return false;
+        for (unsigned int k = 0; k < kidCount; ++k) if (kids[k] >= count) return false;
+        unsigned int empty = 0;
+        for (unsigned int k = 0; k < slotCount; ++k) {
+            if (slots[k] == NONE) ++empty;
+            else if (slots[k] >= count) return false;
+        }
+        return empty > 0 && nameBytes > 0 && names[nameBytes - 1] == '\0';
+    }
+
+    // header and section sizes; sets up the section pointers
+    bool readHeader() {
+        const unsigned int* w = (const unsigned int*)image;
+        const char magic[8] = { 'F', 'T', 'I', 'M', 'A', 'G', 'E', '1' };
+        bool ok = w[2] == VERSION;
+        for (int i = 0; i < 8; ++i) ok = ok && image[i] == magic[i];
+        count = w[3]; rootIdx = w[4]; nameBytes = w[5]; slotCount = w[6]; kidCount = w[7]; textBytes = w[8];
+        ok = ok && count > 0 && count < 0x20000000u && rootIdx < count && slotCount >= 16 && slotCount > count && (slotCount & (slotCount - 1)) == 0
+            && kidCount <= 2 * count && slotCount < 0x40000000u && sizeFor(count, nameBytes, slotCount, kidCount, textBytes) == bytes;
+        if (!ok) return false;
+        rec = w + HEADER / 4;
+        depth = rec + (size_t)count * FIELDS;
+        rows = depth + count;
+        kids = rows + count + 1;
+        slots = kids + kidCount;
+        names = (const char*)(slots + slotCount);
+        text = names + padded(nameBytes);
+        return true;
+    }
+
+    // drops the image (not the scratch)
+    void release() {
+        if (image && !borrowed) {
+#ifdef FT_POSIX_IO
+            munmap(image, (size_t)bytes);
+#else
+            delete[] (unsigned int*)image;
+#endif
+        }
+        image = NULL;
+        bytes = 0;
+        borrowed = false;
+    }
+
+public:
+    static const unsigned int VERSION = 1;
+    static const unsigned int NONE = 0xFFFFFFFFu;
+    static const int HEADER = 40; // bytes
+    static const int FIELDS = 8;  // words per member record
+    static const unsigned int MALE = 1u, ALIVE = 2u;
+
+    // size of an image with these sections (as in the layout above)
+    static long long sizeFor(unsigned int members, unsigned int nameBytes, unsigned int slots, unsigned int kids, unsigned int textBytes) {
+        return HEADER + 4 * tableWords(members, slots, kids) + padded(nameBytes) + padded(textBytes);
+    }
+    // hash slots for n members (load factor <= 0.75, like NameIndex)
+    static unsigned int slotsFor(int n) {
+        unsigned int s = 16;
+        while ((long long)n * 4 > (long long)s * 3) s *= 2;
+        return s;
+    }
+
+    TreeImage() {
+        image = NULL;
+        bytes = 0;
+        borrowed = false;
+        mark = NULL; queue = dist = NULL;
+        scratchCap = 0;
+        epoch = 0;
+        count = rootIdx = nameBytes = slotCount = kidCount = textBytes = 0;
+    }
+    ~TreeImage() { close(); }
+
+    // maps path; false (and closed) if it is missing or not a valid image
+    bool open(const char* path) {
+        close();
+#ifdef FT_POSIX_IO
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < HEADER) { ::close(fd); return false; }
+        bytes = (long long)st.st_size;
+        void* at = mmap(NULL, (size_t)bytes, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // the mapping keeps the file
+        if (at == MAP_FAILED) { bytes = 0; return false; }
+        image = (char*)at;
+#else
+        ifstream file(path, ios::binary | ios::ate);
+        if (!file) return false;
+        bytes = (long long)file.tellg();
+        if (bytes < HEADER) { bytes = 0; return false; }
+        image = (char*)new unsigned int[(size_t)((bytes + 3) / 4)]; // word aligned
+        file.seekg(0);
+        file.read(image, bytes);
+        if (!file) { close(); return false; }
+#endif
+        if (!readHeader() || !linksValid()) { close(); return false; }
+        return true;
+    }
+
+    // views an image built in this process (word aligned, owned by the caller, links trusted);
+    // the walk scratch of an earlier image is reused when it is large enough
+    bool attach(const char* data, long long n) {
+        release();
+        if (n < HEADER) return false;
+        image = (char*)data;
+        bytes = n;
+        borrowed = true;
+        if (!readHeader()) { release(); return false; }
+        return true;
+    }
+
+    void close() {
+        release();
+        if (mark) { delete[] mark; delete[] queue; delete[] dist; }
+        mark = NULL; queue = dist = NULL;
+        scratchCap = 0;
+    }
+
+    bool isOpen() const { return image != NULL; }
+    int size() const { return (int)count; }
+    int root() const { return (int)rootIdx; }
+    const char* nameOf(int i) const { return names + rec[(size_t)i * FIELDS]; }
+    int generationOf(int i) const { return (int)depth[i]; }
+    bool isAlive(int i) const { return (rec[(size_t)i * FIELDS + 7] & ALIVE) != 0; }
+
+    // member index for name (same rules as FamilyTree::find), -1 if none; probes at most
+    // slotCount slots
+    int find(const char* name) const {
+        int len = 0;
+        while (name[len] != '\0') ++len;
+        unsigned int mask = slotCount - 1, k = FamilyMember::hashName(name, len) & mask;
+        for (unsigned int step = 0; step < slotCount && slots[k] != NONE; ++step, k = (k + 1) & mask) {
+            const char* t = nameOf((int)slots[k]);
+            int i = 0;
+            while (i < len && t[i] == name[i]) ++i;
+            if (i == len && t[len] == '\0') return (int)slots[k];
+        }
+        return -1;
+    }
+
+    // breadth-first over parent links (up) or the child rows (down), as LineageIndex does:
+    // each member once with its shortest distance; maxGen = 0 means no limit. out and gens
+    // need size() entries; returns how many were written.
+    int lineage(int i, bool up, int maxGen, int* out, int* gens) {
+        ensureScratch();
+        unsigned int e = nextEpoch();
+        int head = 0, tail = 0, n = 0;
+        mark[i] = e; queue[tail] = i; dist[tail++] = 0;
+        while (head < tail) {
+            int c = queue[head], d = dist[head++];
+            if (maxGen > 0 && d >= maxGen) continue;
+            const unsigned int* r = rec + (size_t)c * FIELDS;
+            unsigned int b = up ? 0 : rows[c], end = up ? 2 : rows[c + 1];
+            for (unsigned int k = b; k < end; ++k) {
+                unsigned int x = up ? r[1 + k] : kids[k];
+                if (x == NONE || mark[x] == e) continue;
+                mark[x] = e;
+                queue[tail] = (int)x; dist[tail++] = d + 1;
+                out[n] = (int)x; if (gens) gens[n] = d + 1; ++n;
+            }
+        }
+        return n;
+    }
+
+    // the full centered tree as it was when published
+    void writeTree(ostream& os) const { os.write(text, textBytes); os.flush(); }
+};
+
+// -------------------------
+// Class: TreeVersion (one published state of a tree, read by other threads)
+// The bytes are a TreeImage built in memory by FamilyTree::publishVersion, so readers walk
+// the member table, the child links, the names and the render text without touching the
+// live tree. Never changed once published; VersionPublisher frees it.
+// -------------------------
+class TreeVersion {
+private:
+    LineBuffer bytes;
+    unsigned long long number;    // 1, 2, ... in publish order
+    unsigned long long retiredAt; // epoch it was replaced in
+    TreeVersion* nextRetired;
+public:
+    explicit TreeVersion(unsigned long long n) { number = n; retiredAt = 0; nextRetired = NULL; }
+
+    LineBuffer& buffer() { return bytes; }
+    const char* data() const { return bytes.data(); }
+    int size() const { return bytes.size(); }
+    unsigned long long getNumber() const { return number; }
+
+    unsigned long long getRetiredAt() const { return retiredAt; }
+    TreeVersion* getNextRetired() const { return nextRetired; }
+    void retire(unsigned long long epoch, TreeVersion* next) { retiredAt = epoch; nextRetired = next; }
+    void setNextRetired(TreeVersion* next) { nextRetired = next; }
+};
+
+// -------------------------
+// Class: VersionPublisher (one writer, many readers that never lock; epoch-based reclamation)
+// The writer builds a TreeVersion off to the side and swaps it in with one atomic exchange,
+// so a reader sees the old version or the new one, each complete. A reader stores the
+// global epoch in its own slot before loading the current version and clears the slot when
+// it is done. A replaced version is stamped with the epoch it was replaced in and freed by
+// a later publish once every slot in use shows a newer epoch: any reader that could have
+// loaded it has finished. Readers claim a slot once (TreeReader). All operations are
+// sequentially consistent, which is what the slot / current ordering relies on.
+// -------------------------
+class VersionPublisher {
+public:
+    static const int MAX_READERS = 64;
+private:
+    atomic<TreeVersion*> current;
+    atomic<unsigned long long> epoch;              // starts at 1; a slot holding 0 is not reading
+    atomic<unsigned long long> active[MAX_READERS];
+    atomic<bool> claimed[MAX_READERS];
+    atomic<int> readers;                           // slots claimed
+    TreeVersion* retired;                          // writer only: replaced, not yet freed
+    int retiredCount;
+
+    VersionPublisher(const VersionPublisher&) = delete;
+    VersionPublisher& operator=(const VersionPublisher&) = delete;
+
+    // frees every retired version no reader can still hold
+    void reclaim() {
+        unsigned long long oldest = ~0ULL;
+        for (int i = 0; i < MAX_READERS; ++i) {
+            unsigned long long e = active[i].load();
+            if (e != 0 && e < oldest) oldest = e;
+        }
+        TreeVersion* keep = NULL;
+        for (TreeVersion* v = retired; v;) {
+            TreeVersion* next = v->getNextRetired();
+            if (v->getRetiredAt() < oldest) { delete v; --retiredCount; }
+            else { v->setNextRetired(keep); keep = v; }
+            v = next;
+        }
+        retired = keep;
+    }
+
+public:
+    VersionPublisher() : current(NULL), epoch(1), readers(0) {
+        for (int i = 0; i < MAX_READERS; ++i) { active[i].store(0); claimed[i].store(false); }
+        retired = NULL;
+        retiredCount = 0;
+    }
+    // no reader may be left by now
+    ~VersionPublisher() {
+        delete current.load();
+        for (TreeVersion* v = retired; v;) { TreeVersion* next = v->getNextRetired(); delete v; v = next; }
+    }
+
+    // writer: v replaces the current version (which is freed once no reader holds it)
+    void publish(TreeVersion* v) {
+        TreeVersion* old = current.exchange(v);
+        if (old) {
+            old->retire(epoch.fetch_add(1), retired);
+            retired = old;
+            ++retiredCount;
+        }
+        reclaim();
+    }
+
+    bool hasReaders() const { return readers.load() > 0; }
+    int pending() const { return retiredCount; } // replaced versions still waiting for readers
+    const TreeVersion* latest() const { return current.load(); }
+
+    // a free slot, or -1 when MAX_READERS readers exist
+    int claimSlot() {
+        for (int i = 0; i < MAX_READERS; ++i) {
+            bool expected = false;
+            if (claimed[i].compare_exchange_strong(expected, true)) { ++readers; return i; }
+        }
+        return -1;
+    }
+    void releaseSlot(int slot) {
+        active[slot].store(0);
+        claimed[slot].store(false);
+        --readers;
+    }
+
+    // reader: the version to use until leave (NULL if nothing was published yet)
+    const TreeVersion* enter(int slot) {
+        active[slot].store(epoch.load());
+        return current.load();
+    }
+    void leave(int slot) { active[slot].store(0); }
+};
+
+// -------------------------
+// Class: TreeReader (one reader thread's handle: a publisher slot and its own TreeImage view)
+//     TreeReader r(tree.versions());
+//     if (TreeImage* v = r.pin()) { v->find(...); v->lineage(...); v->writeTree(out); }
+//     r.unpin(); // from here on the version may be freed
+// The view (and its walk scratch) is reused from pin to pin; it is re-attached only when a
+// newer version has been published. Use one TreeReader per thread.
+// -------------------------
+class TreeReader {
+private:
+    VersionPublisher& publisher;
+    int slot;
+    TreeImage view;
+    unsigned long long shown; // version number the view is attached to (0 = none)
+
+    TreeReader(const TreeReader&) = delete;
+    TreeReader& operator=(const TreeReader&) = delete;
+public:
+    explicit TreeReader(VersionPublisher& p) : publisher(p) { slot = p.claimSlot(); shown = 0; }
+    ~TreeReader() { if (slot >= 0) publisher.releaseSlot(slot); }
+
+    bool isValid() const { return slot >= 0; } // false when every slot was taken
+
+    // the current version, consistent and unchanging until unpin; NULL if none was published
+    TreeImage* pin() {
+        if (slot < 0) return NULL;
+        const TreeVersion* v = publisher.enter(slot);
+        if (!v) { publisher.leave(slot); return NULL; }
+        if (v->getNumber() != shown) {
+            if (!view.attach(v->data(), v->size())) { publisher.leave(slot); shown = 0; return NULL; }
+            shown = v->getNumber();
+        }
+        return &view;
+    }
+    unsigned long long version() const { return shown; }
+    void unpin() { if (slot >= 0) publisher.leave(slot); }
+};
+
+// -------------------------
+// Classes: ExportStream, JsonFamilies, DotFamilies (backends for FamilyTree::exportTree)
+// exportTree runs the generation walk of showCenteredTree, with the same family grouping,
+// and hands each generation's family pairs in print order to a backend that is a template
+// parameter, so there are no virtual calls and no layout: no parentLine / childrenLine text,
+// widths or padding are built. A backend has begin(root, members), generation(g),
+// family(pair) and end(), and writes through an ExportStream, a LineBuffer in front of the
+// output stream that is flushed every FLUSH_AT bytes.
+//   JSON: the layout as data, generation by generation
+//     {"root":NAME,"members":N,"generations":[{"generation":0,"families":[
+//      {"father":MEMBER|null,"mother":MEMBER|null,"children":[MEMBER,...]},...]},...]}
+//     with MEMBER = {"name":"...","gender":"M","alive":true}
+//   DOT:  a Graphviz digraph with one node per member (box = male, ellipse = female,
+//     dashed = late) and an edge from each known parent to the child, written once per
+//     child however often the layout repeats its family.
+// -------------------------
+class ExportStream {
+private:
+    ostream& os;
+    LineBuffer buf;
+public:
+    static const int FLUSH_AT = 64 * 1024;
+
+    explicit ExportStream(ostream& o) : os(o) { buf.reserve(FLUSH_AT + 1024); }
+
+    void put(char c) { buf.put(c); }
+    void put(const char* s) { buf.put(s, (int)strlen(s)); }
+    void put(const char* s, int n) { buf.put(s, n); }
+    void number(int v) {
+        char digits[12];
+        int n = 0;
+        unsigned int u = v < 0 ? 0u - (unsigned int)v : (unsigned int)v;
+        do { digits[n++] = (char)('0' + u % 10); u /= 10; } while (u);
+        if (v < 0) buf.put('-');
+        while (n > 0) buf.put(digits[--n]);
+    }
+    // s[0..n) as a quoted string; JSON escapes (\uXXXX for control bytes), which DOT also reads
+    void quoted(const char* s, int n) {
+        static const char HEX[] = "0123456789abcdef";
+        buf.put('"');
+        for (int i = 0; i < n; ++i) {
+            unsigned char c = (unsigned char)s[i];
+            if (c == '"' || c == '\\') { buf.put('\\'); buf.put((char)c); }
+            else if (c < 0x20) { buf.put("\\u00", 4); buf.put(HEX[c >> 4]); buf.put(HEX[c & 15]); }
+            else buf.put((char)c);
+        }
+        buf.put('"');
+    }
+
+    // between records, so the buffer stays near FLUSH_AT bytes
+    void mayFlush() { if (buf.size() >= FLUSH_AT) buf.flushTo(os); }
+    bool finish() { buf.flushTo(os); os.flush(); return (bool)os; }
+};
+
+class JsonFamilies {
+private:
+    ExportStream& out;
+    int generations;
+    bool firstFamily;
+
+    void member(const FamilyMember* m) {
+        if (!m) { out.put("null"); return; }
+        out.put("{\"name\":");
+        out.quoted(m->getName(), m->getNameLen());
+        out.put(m->getGender() == 'M' ? ",\"gender\":\"M\",\"alive\":" : ",\"gender\":\"F\",\"alive\":");
+        out.put(m->isAlive() ? "true}" : "false}");
+    }
+public:
+    explicit JsonFamilies(ExportStream& o) : out(o) { generations = 0; firstFamily = true; }
+
+    void begin(const FamilyMember* root, int members) {
+        out.put("{\"root\":");
+        out.quoted(root->getName(), root->getNameLen());
+        out.put(",\"members\":");
+        out.number(members);
+        out.put(",\"generations\":[");
+    }
+    void generation(int g) {
+        out.put(generations++ ? "\n]},\n{\"generation\":" : "\n{\"generation\":");
+        out.number(g);
+        out.put(",\"families\":[");
+        firstFamily = true;
+    }
+    void family(const FamilyPair* p) {
+        out.put(firstFamily ? "\n {\"father\":" : ",\n {\"father\":");
+        firstFamily = false;
+        member(p->getFather());
+        out.put(",\"mother\":");
+        member(p->getMother());
+        out.put(",\"children\":[");
+        for (int k = 0; k < p->getChildCount(); ++k) {
+            if (k) out.put(',');
+            member(p->getChild(k));
+        }
+        out.put("]}");
+        out.mayFlush();
+    }
+    void end() { out.put(generations ? "\n]}\n]}\n" : "\n]}\n"); }
+};
+
+class DotFamilies {
+private:
+    ExportStream& out;
+    unsigned char* seen; // per pool index: NODE_WRITTEN | EDGES_WRITTEN
+    static const unsigned char NODE_WRITTEN = 1, EDGES_WRITTEN = 2;
+
+    DotFamilies(const DotFamilies&) = delete;
+    DotFamilies& operator=(const DotFamilies&) = delete;
+
+    void id(const FamilyMember* m) { out.put('m'); out.number(m->getPoolIndex()); }
+    void node(const FamilyMember* m) {
+        unsigned char& s = seen[m->getPoolIndex()];
+        if (s & NODE_WRITTEN) return;
+        s |= NODE_WRITTEN;
+        out.put("  ");
+        id(m);
+        out.put(" [label=");
+        out.quoted(m->getName(), m->getNameLen());
+        out.put(m->getGender() == 'M' ? ", shape=box" : ", shape=ellipse");
+        out.put(m->isAlive() ? "];\n" : ", style=dashed];\n");
+    }
+    void edge(const FamilyMember* from, const FamilyMember* to) {
+        out.put("  ");
+        id(from);
+        out.put(" -> ");
+        id(to);
+        out.put(";\n");
+    }
+public:
+    DotFamilies(ExportStream& o, int members) : out(o) {
+        seen = new unsigned char[members > 0 ? members : 1];
+        for (int i = 0; i < members; ++i) seen[i] = 0;
+    }
+    ~DotFamilies() { delete[] seen; }
+
+    void begin(const FamilyMember* root, int) {
+        out.put("digraph FamilyTree {\n  // root: ");
+        out.put(root->getName(), root->getNameLen());
+        out.put("\n  node [fontname=\"Helvetica\"];\n");
+    }
+    void generation(int g) { out.put("  // generation "); out.number(g); out.put('\n'); }
+    void family(const FamilyPair* p) {
+        const FamilyMember* f = p->getFather();
+        const FamilyMember* m = p->getMother();
+        if (f) node(f);
+        if (m) node(m);
+        for (int k = 0; k < p->getChildCount(); ++k) {
+            const FamilyMember* c = p->getChild(k);
+            node(c);
+            unsigned char& s = seen[c->getPoolIndex()];
+            if (s & EDGES_WRITTEN) continue;
+            s |= EDGES_WRITTEN;
+            if (f) edge(f, c);
+            if (m) edge(m, c);
+        }
+        out.mayFlush();
+    }
+    void end() { out.put("}\n"); }
+};
+
+// -------------------------
+// Class: TreeStats (whole-tree numbers: members per generation, alive / late, families)
+// FamilyTree::statistics fills it in one sweep over the topology arrays: every worker slice
+// sums its members into a TreeStats of its own, and the slices are added up afterwards.
+// From the first query on the tree keeps it current on insert and setAlive; other edits
+// (removal, re-parenting members that have relatives, loads, imports) mark it stale, and the
+// next query sweeps again. A family is a distinct known (father, mother) pair, its size the
+// number of children with that pair; the generation is generationOf (depth).
+// -------------------------
+class TreeStats {
+private:
+    int members, alive, families, familyChildren;
+    SmallArray<int, 32> perGeneration; // members at each depth
+    bool valid;
+
+    TreeStats(const TreeStats&) = delete;
+    TreeStats& operator=(const TreeStats&) = delete;
+
+    void count(int d, int delta) {
+        if (d >= perGeneration.size()) {
+            int old = perGeneration.size();
+            perGeneration.resize(d + 1);
+            for (int g = old; g <= d; ++g) perGeneration[g] = 0;
+        }
+        perGeneration[d] += delta;
+    }
+
+public:
+    TreeStats() { clear(); }
+
+    void clear() {
+        members = alive = families = familyChildren = 0;
+        perGeneration.clear();
+        valid = false;
+    }
+    bool isValid() const { return valid; }
+    void invalidate() { valid = false; }
+    void validate() { valid = true; }
+
+    // ---- updates (sweep slices and the tree's incremental upkeep) ----
+    void addMember(int depth, bool isAlive) { ++members; if (isAlive) ++alive; count(depth, 1); }
+    void moveMember(int fromDepth, int toDepth) { count(fromDepth, -1); count(toDepth, 1); }
+    void aliveChanged(bool nowAlive) { alive += nowAlive ? 1 : -1; }
+    void addFamilies(int newFamilies, int children) { families += newFamilies; familyChildren += children; }
+    void add(const TreeStats& o) {
+        members += o.members; alive += o.alive;
+        families += o.families; familyChildren += o.familyChildren;
+        for (int g = o.perGeneration.size() - 1; g >= 0; --g) if (o.perGeneration[g]) count(g, o.perGeneration[g]);
+    }
+
+    // ---- results ----
+    int memberCount() const { return members; }
+    int aliveCount() const { return alive; }
+    int lateCount() const { return members - alive; }
+    int familyCount() const { return families; }
+    double averageFamilySize() const { return families ? (double)familyChildren / families : 0.0; }
+    // generations holding somebody (the deepest is generations() - 1)
+    int generations() const {
+        int g = perGeneration.size();
+        while (g > 0 && perGeneration[g - 1] == 0) --g;
+        return g;
+    }
+    int generationSize(int g) const { return g >= 0 && g < perGeneration.size() ? perGeneration[g] : 0; }
+    // the first of the largest generations
+    int widestGeneration() const {
+        int best = 0;
+        for (int g = 1; g < perGeneration.size(); ++g) if (perGeneration[g] > perGeneration[best]) best = g;
+        return best;
+    }
+
+    void print(ostream& os) const {
+        char line[160];
+        int gens = generations(), wide = widestGeneration();
+        snprintf(line, sizeof(line), "Members: %d (%d alive, %d late, %.1f%% alive)\n", members, alive, members - alive,
+                 members ? 100.0 * alive / members : 0.0);
+        os << line;
+        snprintf(line, sizeof(line), "Generations: %d (deepest %d), widest: generation %d with %d members\n", gens,
+                 gens - 1, wide, generationSize(wide));
+        os << line;
+        snprintf(line, sizeof(line), "Families: %d, average size %.2f children\n", families, averageFamilySize());
+        os << line;
+        os << "Members per generation:\n";
+        for (int g = 0; g < gens; ++g) os << "  " << g << ": " << perGeneration[g] << "\n";
+    }
+};
+
+// -------------------------
+// Class: FamilyTree
+// -------------------------
+class FamilyTree {
+private:
+    FamilyMember* root;
+
+    // every member in creation order (a member's pool index is its position here)
+    SmallArray<FamilyMember*, 8> memberPool;
+
+    NamePool namePool;   // interned names of all members
+    NameIndex nameIndex; // exact-name lookup, kept in sync by poolAdd
+    NameTrie nameOrder;  // alphabetical order and prefix queries, also kept in sync by poolAdd
+    MemberTopology topo; // index-based links + flags, kept in sync by the mutators below
+    bool depthStale;     // bulk loads set links out of order; depths are recomputed on next query
+    LineageIndex lineage; // per-parent child rows for lineage queries, rebuilt lazily
+    int* queryScratch;   // lineage results as pool indices (memberPool.capacity() entries)
+    int queryScratchCap;
+    Arena memberArena;   // stable storage for every FamilyMember (freed with the tree)
+    SmallArray<FamilyMember*, 8> freeMembers; // storage of removed members, reused by createMember
+    Arena pairArena[2];  // render scratch: current / next generation's FamilyPairs
+    PairIndex pairIndex; // render scratch: groups a generation's children by parent pair
+    unsigned int visitEpoch; // last stamp handed out by nextVisitEpoch()
+    SmallArray<FamilyMember*, 16> renderChildren; // render scratch: a generation's distinct children
+    RenderCache renderCache; // last render's output, replayed / partially rebuilt
+    FamilyPair** renderPairs; // render scratch: the generation's pairs in print order
+    int* renderOffsets;       // render scratch: column where each pair's block starts
+    int renderPairCap;
+
+    int* renderChildStart;    // render scratch: position of each pair's first child in the generation
+    atomic<unsigned long long>* renderSeen; // parallel dedup: (epoch << 32) | first position, per member
+    int renderSeenCap;
+    Arena* sliceArenas;       // parallel discovery: per-slice pair buckets (WorkSplitter::MAX_WORKERS)
+    PairIndex* slicePairs;
+
+    TreeStats stats;            // statistics(): kept current from the first query on
+
+    VersionPublisher versionsOut; // published versions for reader threads (TreeReader)
+    unsigned long long edits;     // mutations so far (createMember, the link mutators, loads)
+    unsigned long long editsPublished; // edits the latest published version includes
+    unsigned long long versionCount;
+
+    Journal journal;          // write-ahead log of mutations (when started with --journal)
+    bool journalPaused;       // bulk import / load: not logged, followed by a checkpoint
+    char journalLog[272];     // <base>.log
+    char journalSnap[272];    // <base>.snap, the snapshot the journal follows
+    unsigned int journalGeneration; // checkpoint number of journalSnap (0: no snapshot yet)
+
+    // generations with at least this many families per worker are laid out in parallel
+    static const int LAYOUT_GRAIN = 2048;
+    // next generations are discovered in parallel once each worker gets this many children
+    static const int DISCOVERY_GRAIN = 4096;
+    // most members an edit updates the depth of before leaving depths to be recomputed
+    static const int DEPTH_REFRESH_LIMIT = 4096;
+    // statistics are swept in parallel once each worker gets this many members
+    static const int STATS_GRAIN = 65536;
+    // siblings an insert compares against to tell whether it starts a new family; beyond
+    // that the statistics are left to the next sweep
+    static const int FAMILY_CHECK_LIMIT = 64;
+
+    // fresh stamp for FamilyMember::markVisited; 0 is never handed out
+    unsigned int nextVisitEpoch() {
+        if (++visitEpoch == 0) {
+            for (int i = 0; i < memberPool.size(); ++i) memberPool[i]->clearVisited();
+            for (int i = 0; i < renderSeenCap; ++i) renderSeen[i].store(0, memory_order_relaxed);
+            visitEpoch = 1;
+        }
+        return visitEpoch;
+    }
+
+    // grow the pool once to hold n members in total
+    void reserveMembers(int n) {
+        if (n <= memberPool.capacity()) return;
+        FT_COUNT(MEMBER_POOL_GROWS, 1);
+        memberPool.reserve(n);
+        nameIndex.reserve(n);
+        nameOrder.reserve(n);
+        topo.reserve(n);
+    }
+
+    // Add to pool for later traversal (storage itself belongs to memberArena)
+    void poolAdd(FamilyMember* m) {
+        if (memberPool.full()) FT_COUNT(MEMBER_POOL_GROWS, 1);
+        m->setPoolIndex(memberPool.size());
+        memberPool.push(m);
+        nameIndex.insert(m);
+        nameOrder.insert(namePool, m->getNameOffset(), m->getNameLen(), m->getPoolIndex());
+    }
+
+    // allocate a member (a removed member's storage first, else the arena) and register it in the pool
+    FamilyMember* createMember(const char* name, char g, bool alive) {
+        void* at;
+        if (freeMembers.size() > 0) { at = freeMembers.pop(); FT_COUNT(MEMBER_SLOTS_REUSED, 1); }
+        else at = memberArena.alloc(sizeof(FamilyMember));
+        FamilyMember* m = new (at) FamilyMember(namePool, name, g, alive);
+        ++edits;
+        poolAdd(m);
+        topo.append(m->getGender() == 'M', alive);
+        if (stats.isValid()) stats.addMember(0, alive);
+        if (journaling()) journal.log(Journal::CREATE, (m->getGender() == 'M' ? Journal::MALE : 0u) | (alive ? Journal::IS_ALIVE : 0u),
+                                      0, 0, 0, m->getName(), m->getNameLen());
+        return m;
+    }
+
+    // create a member and link it the way addMemberInteractive does (no checks)
+    FamilyMember* linkNewMember(const char* name, char g, bool alive, FamilyMember* father, FamilyMember* mother) {
+        FamilyMember* nm = createMember(name, g, alive);
+        setParents(nm, father, mother);
+        if (father) attachChild(father, nm);
+        else if (mother) attachChild(mother, nm);
+        else attachChild(root, nm);
+        return nm;
+    }
+
+    static int indexOf(const FamilyMember* m) { return m ? m->getPoolIndex() : MemberTopology::NONE; }
+    FamilyMember* memberAt(int i) const { return i == MemberTopology::NONE ? NULL : memberPool[i]; }
+
+    bool journaling() const { return journal.isOpen() && !journalPaused; }
+
+    // ---- mutators: every link / flag change goes through these so topo stays in sync ----
+    // (and is logged to the journal when one is open)
+    // render cache: a new child of parent shows up in the generation after parent is printed in
+    void attachChild(FamilyMember* parent, FamilyMember* child) {
+        ++edits;
+        int shown = renderCache.printedIn(parent->getPoolIndex());
+        if (shown >= 0) renderCache.markDirty(shown + 1);
+        FamilyMember* prevTail = parent->getLastChild();
+        parent->addChild(child);
+        if (prevTail) topo.setNextSibling(prevTail->getPoolIndex(), child->getPoolIndex());
+        else topo.setFirstChild(parent->getPoolIndex(), child->getPoolIndex());
+        if (journaling()) journal.log(Journal::ATTACH, 0, (unsigned int)parent->getPoolIndex(), (unsigned int)child->getPoolIndex(), 0);
+    }
+
+    // render cache: generation 0 is every child of root; otherwise the child's own family block changes
+    void setParents(FamilyMember* child, FamilyMember* f, FamilyMember* m) {
+        ++edits;
+        // statistics: kept only for a member without relatives yet (an insert)
+        bool fresh = stats.isValid() && !child->getFather() && !child->getMother() && !child->getFirstChild()
+            && topo.getFirstCoChild(child->getPoolIndex()) == MemberTopology::NONE;
+        if (stats.isValid() && !fresh) stats.invalidate();
+        int oldDepth = topo.getDepth(child->getPoolIndex());
+        if (f == root || m == root || child == root) renderCache.markDirty(0);
+        int shown = renderCache.printedIn(child->getPoolIndex());
+        if (shown >= 0) renderCache.markDirty(shown);
+        child->setFather(f);
+        child->setMother(m);
+        topo.setParents(child->getPoolIndex(), indexOf(f), indexOf(m));
+        // parents are always linked before their children interactively, so this is exact
+        // there; bulk paths mark depthStale instead
+        topo.updateDepth(child->getPoolIndex());
+        lineage.invalidate();
+        if (fresh) {
+            stats.moveMember(oldDepth, topo.getDepth(child->getPoolIndex()));
+            if (f || m) {
+                int known = startsFamily(child);
+                if (known < 0) stats.invalidate();
+                else stats.addFamilies(known, 1);
+            }
+        }
+        if (journaling()) journal.log(Journal::PARENTS, 0, (unsigned int)child->getPoolIndex(), (unsigned int)indexOf(f), (unsigned int)indexOf(m));
+    }
+
+    // Members [b, e) into out: their generation and status, and the families in their own
+    // child chains. Every child is listed by exactly one holder (holderOf), so distinct
+    // parent pairs are counted per chain: a small stamped hash of the chain's mothers
+    // (-2 for a child listed under its mother alone), sized for the longest chain in range.
+    void sweepStatsRange(int b, int e, TreeStats& out) const {
+        const int NONE = MemberTopology::NONE;
+        int longest = 0;
+        for (int i = b; i < e; ++i)
+            if (topo.getFirstChild(i) != NONE && memberPool[i]->getChildCount() > longest) longest = memberPool[i]->getChildCount();
+        int size = 16;
+        while (size < 2 * longest) size *= 2;
+        int* key = new int[size];
+        int* owner = new int[size]; // holder the slot was filled for
+        for (int k = 0; k < size; ++k) owner[k] = NONE;
+
+        int families = 0, children = 0;
+        for (int i = b; i < e; ++i) {
+            out.addMember(topo.getDepth(i), topo.isAlive(i));
+            if (topo.getFather(i) != NONE || topo.getMother(i) != NONE) ++children;
+            for (int c = topo.getFirstChild(i); c != NONE; c = topo.getNextSibling(c)) {
+                int f = topo.getFather(c), m = topo.getMother(c);
+                int id;
+                if (f == i) id = m;
+                else if (f == NONE && m == i) id = -2;
+                else continue; // listed under root without parents
+                int h = (int)(((unsigned int)id * 2654435761u) & (unsigned int)(size - 1));
+                while (owner[h] == i && key[h] != id) h = (h + 1) & (size - 1);
+                if (owner[h] != i) { owner[h] = i; key[h] = id; ++families; }
+            }
+        }
+        out.addFamilies(families, children);
+        delete[] key;
+        delete[] owner;
+    }
+
+    // statistics from scratch: one pass, split across workers, slices added up in order
+    void sweepStatistics() {
+        ensureDepths();
+        stats.clear();
+        int n = memberPool.size();
+        int slices = WorkSplitter::slices(n, STATS_GRAIN);
+        TreeStats* part = slices > 1 ? new TreeStats[slices] : NULL;
+        WorkSplitter::runSlices(n, STATS_GRAIN, [&](int slice, int b, int e) {
+            sweepStatsRange(b, e, part ? part[slice] : stats);
+        });
+        for (int k = 0; part && k < slices; ++k) stats.add(part[k]);
+        delete[] part;
+        stats.validate();
+    }
+
+    // upward queries need valid depths and walk scratch; descendant queries also need the rows
+    void ensureLineage(bool rows) {
+        ensureDepths();
+        if (rows && lineage.isStale()) lineage.rebuild(topo);
+        else lineage.reserve(memberPool.size());
+        if (queryScratchCap < memberPool.size()) {
+            if (queryScratch) delete[] queryScratch;
+            queryScratchCap = memberPool.capacity();
+            queryScratch = new int[queryScratchCap];
+        }
+    }
+
+    void ensureDepths() {
+        if (depthStale) { topo.recomputeDepths(); depthStale = false; }
+    }
+
+    void setAlive(FamilyMember* m, bool a) {
+        ++edits;
+        if (stats.isValid() && m->isAlive() != a) stats.aliveChanged(a);
+        m->setAlive(a);
+        topo.setAlive(m->getPoolIndex(), a);
+        if (journaling()) journal.log(Journal::ALIVE, 0, (unsigned int)m->getPoolIndex(), a ? 1u : 0u, 0);
+    }
+
+    // the member whose child chain lists c: its father, else its mother, else root
+    FamilyMember* holderOf(const FamilyMember* c) const {
+        if (c->getFather()) return c->getFather();
+        return c->getMother() ? c->getMother() : root;
+    }
+
+    // 1 if no other child of c's holder has c's two parents (c starts a family), 0 if one
+    // does, -1 if that was not settled within FAMILY_CHECK_LIMIT siblings (newest first)
+    int startsFamily(const FamilyMember* c) const {
+        int steps = 0;
+        for (const FamilyMember* s = holderOf(c)->getLastChild(); s; s = s->getPrevSibling()) {
+            if (s == c) continue;
+            if (s->getFather() == c->getFather() && s->getMother() == c->getMother()) return 0;
+            if (++steps == FAMILY_CHECK_LIMIT) return -1;
+        }
+        return 1;
+    }
+
+    // Unlinks child from parent's chain in O(1) through its prevSibling link. Render cache as
+    // for attachChild. Only used by reparent and removeMember, which are logged as one record.
+    void detachChild(FamilyMember* parent, FamilyMember* child) {
+        ++edits;
+        int shown = renderCache.printedIn(parent->getPoolIndex());
+        if (shown >= 0) renderCache.markDirty(shown + 1);
+        FamilyMember* prev = child->getPrevSibling();
+        FamilyMember* next = child->getNextSibling();
+        parent->removeChild(child);
+        if (prev) topo.setNextSibling(prev->getPoolIndex(), indexOf(next));
+        else topo.setFirstChild(parent->getPoolIndex(), indexOf(next));
+        topo.setNextSibling(child->getPoolIndex(), MemberTopology::NONE);
+    }
+
+    // new parents for c, which is listed under from; it moves to the chain of its new holder
+    void relink(FamilyMember* c, FamilyMember* f, FamilyMember* m, FamilyMember* from) {
+        setParents(c, f, m);
+        FamilyMember* to = holderOf(c);
+        if (to != from) {
+            detachChild(from, c);
+            attachChild(to, c);
+        }
+        refreshDepths(c->getPoolIndex());
+    }
+
+    // i's depth was just recomputed by setParents: carry the change down to its descendants,
+    // only as far as depths actually change (nothing to keep while they are stale anyway).
+    // A change reaching more than DEPTH_REFRESH_LIMIT members (a long line of descent) is
+    // left to one recomputation on the next query instead, so an edit never walks the tree.
+    void refreshDepths(int i) {
+        if (depthStale) return;
+        SmallArray<int, 64> work;
+        work.push(i);
+        for (int visited = 0; work.size() > 0; ++visited) {
+            if (visited == DEPTH_REFRESH_LIMIT) { depthStale = true; stats.invalidate(); return; }
+            int p = work.pop();
+            for (int pass = 0; pass < 2; ++pass) { // listed children, then co-children
+                int c = pass == 0 ? topo.getFirstChild(p) : topo.getFirstCoChild(p);
+                for (; c != MemberTopology::NONE; c = pass == 0 ? topo.getNextSibling(c) : topo.getNextCoChild(c)) {
+                    if (topo.getFather(c) != p && topo.getMother(c) != p) continue; // root's visibility list
+                    int before = topo.getDepth(c);
+                    topo.updateDepth(c);
+                    if (topo.getDepth(c) != before) work.push(c);
+                }
+            }
+        }
+    }
+
+    // simple name equality
+    bool eq(const char* a, const char* b) const {
+        int i = 0;
+        while (a[i] != '\0' || b[i] != '\0') {
+            if (a[i] != b[i]) return false;
+            ++i;
+        }
+        return true;
+    }
+
+    // find member by name (hash lookup; same result as scanning the pool in order)
+    FamilyMember* findByName(const char* name) {
+        FT_COUNT(NAME_LOOKUPS, 1);
+        int len = 0;
+        while (name[len] != '\0') ++len; // full length: over-long probes never match, as before
+        return nameIndex.find(name, len, FamilyMember::hashName(name, len));
+    }
+
+    // Recursively collect all members into pool (if we didn't maintain pool)
+    void collectAllRecursive(FamilyMember* node) {
+        if (!node) return;
+        poolAdd(node);
+        FamilyMember* c = node->getFirstChild();
+        while (c) { collectAllRecursive(c); c = c->getNextSibling(); }
+        // siblings are included when their parents traverse, root's siblings none.
+    }
+
+    // Build family pairs list for a given set of members.
+    // We'll create a linked list of FamilyPair nodes (allocated in arena) in insertion order.
+    FamilyPair* buildFamilyPairsForMembers(FamilyMember** members, int count, Arena& arena) {
+        FamilyPair* head = NULL;
+        FamilyPair* tail = NULL;
+        pairIndex.clear();
+        // For each member, check their parents and add to corresponding pair
+        for (int i = 0; i < count; ++i) {
+            FamilyMember* child = members[i];
+            FamilyMember* f = child->getFather();
+            FamilyMember* m = child->getMother();
+
+            // If both parents NULL AND child != root, treat child as own family with Unknown parents attached to root?
+            // We'll still create a pair (father,mother) possibly both NULL representing unattached
+            // But avoid duplicates: check if pair exists already
+            FamilyPair* cur = pairIndex.find(f, m);
+            if (cur) { cur->addChild(child); continue; }
+            FamilyPair* np = FamilyPair::create(arena, f, m);
+            np->addChild(child);
+            pairIndex.insert(f, m, np);
+            if (tail == NULL) { head = tail = np; }
+            else { tail->setNext(np); tail = np; }
+        }
+        return head;
+    }
+
+    // Helper to truncate and format a single name for display (max MAX_NAME chars)
+    static void formatName(const char* src, char* out, int outSize) {
+        int i = 0;
+        while (i < MAX_NAME && src[i] != '\0' && i < outSize - 1) { out[i] = src[i]; ++i; }
+        out[i] = '\0';
+    }
+
+    // Fills renderPairs with the generation's pairs in print order; returns how many.
+    int listPairs(FamilyPair* head) {
+        int count = 0;
+        for (FamilyPair* t = head; t; t = t->getNext()) ++count;
+        if (count > renderPairCap) {
+            if (renderPairs) { delete[] renderPairs; delete[] renderOffsets; delete[] renderChildStart; }
+            renderPairCap = count * 2;
+            renderPairs = new FamilyPair * [renderPairCap];
+            renderOffsets = new int[renderPairCap + 1];
+            renderChildStart = new int[renderPairCap + 1];
+        }
+        count = 0;
+        for (FamilyPair* t = head; t; t = t->getNext()) renderPairs[count++] = t;
+        return count;
+    }
+
+    // generation 0 of the full view, grouped into pairArena[side] (used by renderTree and
+    // walkFamilies; maxFamilies as in renderTree)
+    FamilyPair* firstGeneration(int side, int maxFamilies, bool& hiddenFamilies) {
+        // gather all members into array (memberPool already maintained)
+        // We'll create array of pointers pointing to all members
+        FamilyMember** all = memberPool.data();
+        int total = memberPool.size();
+
+        // Build mapping child -> parent pair is implicit. We'll find families for current level by checking parents = something
+        // We'll use a simple iterative BFS by generation: start with families where both parents are NULL (top-level families)
+        // But many real trees have root as an ancestor with no parents. We'll treat families by parent pair identity.
+
+        // To avoid complexity of true spatial layout, we'll produce centered blocks per family per generation.
+        // Step 1: For generation 0, find families where parents have no parents themselves (parents are top)
+        // We'll instead pick families where at least one parent is root or has no parents.
+        // Simpler: start generation 0 as families that include root as a parent OR members with no parents attached (root)
+        // Then iteratively build next generations using the children of families in previous generation.
+
+        // Build initial family list for generation: families that contain members who have father==root or mother==root or whose parents are both NULL and the member is root.
+        FamilyPair* genHead = NULL;
+        FamilyPair* genTail = NULL;
+
+        // Helper to append a pair node to list
+        auto appendPair = [&](FamilyPair* p) {
+            if (!genHead) { genHead = genTail = p; }
+            else { genTail->setNext(p); genTail = p; }
+            };
+
+        // For every member, if their parent pair includes root or both parents null and member is root, include that pair
+        pairIndex.clear();
+        int genFamilies = 0;       // families in the generation being built
+        // (scans the topology arrays; member objects are only touched for included children)
+        const int rootIdx = root->getPoolIndex();
+        const int NONE = MemberTopology::NONE;
+        for (int i = 0; i < total; ++i) {
+            int fi = topo.getFather(i), mi = topo.getMother(i);
+            bool include = false;
+            if (fi == rootIdx || mi == rootIdx) include = true;
+            if (fi == NONE && mi == NONE && i == rootIdx) include = true;
+            if (!include) continue;
+            FamilyMember* ch = all[i];
+            FamilyMember* f = memberAt(fi);
+            FamilyMember* m = memberAt(mi);
+
+            // check existing pair in genHead
+            FamilyPair* cur = pairIndex.find(f, m);
+            if (cur) { cur->addChild(ch); continue; }
+            if (maxFamilies > 0 && genFamilies >= maxFamilies) { hiddenFamilies = true; continue; }
+            ++genFamilies;
+            FamilyPair* np = FamilyPair::create(pairArena[side], f, m);
+            np->addChild(ch);
+            pairIndex.insert(f, m, np);
+            appendPair(np);
+        }
+
+        // Now we will print generation by generation using family pairs, and build next generation list from children who are parents themselves
+        FamilyPair* currentGen = genHead;
+
+        if (!currentGen) {
+            // Fallback: if nothing found (strange), create one family containing root
+            FamilyPair* np = FamilyPair::create(pairArena[side], NULL, NULL);
+            np->addChild(root);
+            currentGen = np;
+        }
+        return currentGen;
+    }
+
+    // The generation walk of renderTree (no limits) with the layout replaced by a backend
+    // (JsonFamilies / DotFamilies); the same families in the same order. Needs a root.
+    template <class Backend>
+    void walkFamilies(Backend& out) {
+        int side = 0;
+        pairArena[0].reset(); pairArena[1].reset();
+        bool hiddenFamilies = false;
+        FamilyPair* currentGen = firstGeneration(side, 0, hiddenFamilies);
+        out.begin(root, memberPool.size());
+        for (int generation = 0; currentGen; ++generation) {
+            int count = listPairs(currentGen);
+            FamilyPair** pairs = renderPairs;
+            out.generation(generation);
+            for (int i = 0; i < count; ++i) out.family(pairs[i]);
+
+            int childCount = collectChildren(pairs, count);
+            FamilyPair* nextGenHead = NULL; FamilyPair* nextGenTail = NULL;
+            int genFamilies = 0;
+            groupChildren(renderChildren.data(), childCount, 1 - side, 0, nextGenHead, nextGenTail, genFamilies, hiddenFamilies);
+            pairArena[side].reset();
+            side = 1 - side;
+            currentGen = nextGenHead;
+        }
+        out.end();
+    }
+
+    // Lays out one generation's family blocks (list from head) into renderPairs and appends its
+    // three rows (parents, connectors, children) and a blank line to out; returns the block count.
+    int writeGeneration(FamilyPair* head, LineBuffer& out) {
+        // For current generation, compute widths for each family block (parentLine and childrenLine)
+        // We'll build arrays by traversing linked list to count nodes
+        int count = listPairs(head);
+        FamilyPair** pairs = renderPairs;
+        int* offsets = renderOffsets;
+
+        // lay out every family block: lines and widths are cached on the pair, text lives in
+        // the generation's arena (no per-line heap buffers). Buffers are taken from the arena
+        // in order, then the blocks are formatted independently, in parallel when wide.
+        for (int i = 0; i < count; ++i) pairs[i]->reserveLayout();
+        WorkSplitter::run(count, LAYOUT_GRAIN, [pairs](int b, int e) {
+            for (int i = b; i < e; ++i) pairs[i]->format();
+        });
+
+        // block i starts at column offsets[i] (prefix sum of widths + HSPACE gaps);
+        // offsets[count] - HSPACE is the width of the whole generation
+        offsets[0] = 0;
+        for (int i = 0; i < count; ++i) offsets[i + 1] = offsets[i] + pairs[i]->getWidth() + HSPACE;
+        int totalLineWidth = offsets[count] - HSPACE;
+
+        // we will print three rows: parents, connectors and children. Each row is composed in
+        // place in out; every block knows its offset, so the blocks of a wide
+        // generation are written in parallel.
+        static const char CONNECTOR[] = "│";
+        const int connectorLen = (int)sizeof(CONNECTOR) - 1; // UTF-8 bytes, one display column
+
+        // Parents row: center parent text in block width, separated by HSPACE
+        char* row = out.extend(totalLineWidth);
+        WorkSplitter::run(count, LAYOUT_GRAIN, [=](int b, int e) {
+            for (int i = b; i < e; ++i) {
+                FamilyPair* t = pairs[i];
+                char* o = row + offsets[i];
+                int w = t->getWidth(), len = t->getParentLen();
+                int padLeft = (w - len) / 2;
+                for (int k = 0; k < padLeft; ++k) o[k] = ' ';
+                const char* txt = t->getParentText();
+                for (int k = 0; k < len; ++k) o[padLeft + k] = txt[k];
+                for (int k = padLeft + len; k < w; ++k) o[k] = ' ';
+                if (i + 1 < count) for (int k = 0; k < HSPACE; ++k) o[w + k] = ' ';
+            }
+        });
+        out.put('\n');
+
+        // Print connector line: draw a vertical connector from parents to center and a down connector to children
+        // (each earlier block's connector adds connectorLen - 1 bytes before block i)
+        row = out.extend(totalLineWidth + count * (connectorLen - 1));
+        WorkSplitter::run(count, LAYOUT_GRAIN, [=](int b, int e) {
+            for (int i = b; i < e; ++i) {
+                FamilyPair* t = pairs[i];
+                char* o = row + offsets[i] + i * (connectorLen - 1);
+                int w = t->getWidth(), len = t->getParentLen();
+                int padLeft = (w - len) / 2;
+                int pre = padLeft + len / 2; // approximate center pos inside block
+                for (int k = 0; k < pre; ++k) o[k] = ' ';
+                for (int k = 0; k < connectorLen; ++k) o[pre + k] = CONNECTOR[k];
+                // pad rest of block
+                for (int k = pre + connectorLen; k < w + connectorLen - 1; ++k) o[k] = ' ';
+                if (i + 1 < count) for (int k = 0; k < HSPACE; ++k) o[w + connectorLen - 1 + k] = ' ';
+            }
+        });
+        out.put('\n');
+
+        // Children row
+        row = out.extend(totalLineWidth);
+        WorkSplitter::run(count, LAYOUT_GRAIN, [=](int b, int e) {
+            for (int i = b; i < e; ++i) {
+                FamilyPair* t = pairs[i];
+                char* o = row + offsets[i];
+                int w = t->getWidth(), len = t->getChildLen();
+                int padLeft = (w - len) / 2;
+                for (int k = 0; k < padLeft; ++k) o[k] = ' ';
+                const char* txt = t->getChildText();
+                for (int k = 0; k < len; ++k) o[padLeft + k] = txt[k];
+                for (int k = padLeft + len; k < w; ++k) o[k] = ' ';
+                if (i + 1 < count) for (int k = 0; k < HSPACE; ++k) o[w + k] = ' ';
+            }
+        });
+        out.put('\n'); out.put('\n');
+        return count;
+    }
+
+    // Distinct children of a generation's pairs, in first-occurrence order, into renderChildren;
+    // returns how many. Wide generations are cut into position slices (pairs[i]'s children start
+    // at renderChildStart[i]): pass 1 keeps, per member, the smallest position it occurs at
+    // (atomic min on an epoch-stamped word), which is the occurrence the serial walk keeps; pass 2
+    // has each slice keep its first occurrences in place, and the slices are then packed in order.
+    int collectChildren(FamilyPair** pairs, int count) {
+        unsigned int seen = nextVisitEpoch();
+        int totalChildren = 0;
+        for (int i = 0; i < count; ++i) { renderChildStart[i] = totalChildren; totalChildren += pairs[i]->getChildCount(); }
+        renderChildStart[count] = totalChildren;
+        // the array is tree-owned scratch so it is only reallocated when a generation is wider than any before
+        renderChildren.clear();
+        renderChildren.resize(totalChildren);
+        FamilyMember** childList = renderChildren.data();
+
+        if (WorkSplitter::slices(totalChildren, DISCOVERY_GRAIN) < 2) {
+            int childCount = 0;
+            for (int i = 0; i < count; ++i) {
+                int cc = pairs[i]->getChildCount();
+                for (int k = 0; k < cc; ++k) {
+                    FamilyMember* ch = pairs[i]->getChild(k);
+                    // avoid duplicates (members stamped earlier in this generation)
+                    if (ch->markVisited(seen)) childList[childCount++] = ch;
+                }
+            }
+            return childCount;
+        }
+
+        if (renderSeenCap < memberPool.size()) {
+            if (renderSeen) delete[] renderSeen;
+            renderSeenCap = memberPool.capacity();
+            renderSeen = new atomic<unsigned long long>[renderSeenCap];
+            for (int i = 0; i < renderSeenCap; ++i) renderSeen[i].store(0, memory_order_relaxed);
+        }
+        atomic<unsigned long long>* firstSeen = renderSeen;
+        const int* start = renderChildStart;
+        const unsigned long long stamp = (unsigned long long)seen << 32;
+
+        // pair holding position b (last pair starting at or before it)
+        auto pairAt = [count, start](int b) {
+            int lo = 0, hi = count - 1;
+            while (lo < hi) { int mid = (lo + hi + 1) / 2; if (start[mid] <= b) lo = mid; else hi = mid - 1; }
+            return lo;
+        };
+
+        // pass 1: first occurrence of every child
+        WorkSplitter::run(totalChildren, DISCOVERY_GRAIN, [=](int b, int e) {
+            for (int i = pairAt(b), p = b; p < e; ++i) {
+                for (int k = p - start[i]; k < pairs[i]->getChildCount() && p < e; ++k, ++p) {
+                    atomic<unsigned long long>& slot = firstSeen[pairs[i]->getChild(k)->getPoolIndex()];
+                    unsigned long long want = stamp | (unsigned int)p;
+                    unsigned long long v = slot.load(memory_order_relaxed);
+                    while ((v & ~0xFFFFFFFFull) != stamp || v > want)
+                        if (slot.compare_exchange_weak(v, want, memory_order_relaxed)) break;
+                }
+            }
+        });
+
+        // pass 2: each slice keeps its first occurrences from its own first position on
+        int sliceBegin[WorkSplitter::MAX_WORKERS], sliceEnd[WorkSplitter::MAX_WORKERS];
+        int slices = WorkSplitter::slices(totalChildren, DISCOVERY_GRAIN);
+        WorkSplitter::runSlices(totalChildren, DISCOVERY_GRAIN, [&, stamp](int slice, int b, int e) {
+            int kept = b;
+            for (int i = pairAt(b), p = b; p < e; ++i) {
+                for (int k = p - start[i]; k < pairs[i]->getChildCount() && p < e; ++k, ++p) {
+                    FamilyMember* ch = pairs[i]->getChild(k);
+                    if (firstSeen[ch->getPoolIndex()].load(memory_order_relaxed) == (stamp | (unsigned int)p))
+                        childList[kept++] = ch;
+                }
+            }
+            sliceBegin[slice] = b;
+            sliceEnd[slice] = kept;
+        });
+        int childCount = 0;
+        for (int k = 0; k < slices; ++k)
+            for (int i = sliceBegin[k]; i < sliceEnd[k]; ++i) childList[childCount++] = childList[i];
+        return childCount;
+    }
+
+    // Next generation from a generation's distinct children: each child's own children, grouped
+    // by parent pair in order of first appearance, appended to head / tail in pairArena[nextSide].
+    // Wide generations are grouped in parallel: every slice of children fills its own arena and
+    // PairIndex (in order), and the buckets are merged slice by slice, so pair order, children
+    // order and maxFamilies cut-offs all match the serial walk.
+    void groupChildren(FamilyMember** childList, int childCount, int nextSide, int maxFamilies,
+                       FamilyPair*& head, FamilyPair*& tail, int& genFamilies, bool& hidden) {
+        const int NONE = MemberTopology::NONE;
+        pairIndex.clear();
+        genFamilies = 0;
+        hidden = false;
+
+        if (WorkSplitter::slices(childCount, DISCOVERY_GRAIN) < 2) {
+            // For each child in childList, if this child is a parent of someone (i.e., has firstChild), we create a FamilyPair for that child's children
+            for (int i = 0; i < childCount; ++i) {
+                int potentialParent = childList[i]->getPoolIndex();
+                if (topo.getFirstChild(potentialParent) == NONE) continue; // not a parent
+                // For each of potentialParent's children, we need to find the partner (spouse) pointer: child's father/mother combined
+                // For each child c = potentialParent->firstChild ... determine the pair (father,mother) and add family pair
+                // (links are read from the topology arrays)
+                for (int ci = topo.getFirstChild(potentialParent); ci != NONE; ci = topo.getNextSibling(ci)) {
+                    FamilyMember* cnode = memberPool[ci];
+                    FamilyMember* f = memberAt(topo.getFather(ci));
+                    FamilyMember* m = memberAt(topo.getMother(ci));
+                    // find existing pair in nextGenHead
+                    FamilyPair* cur = pairIndex.find(f, m);
+                    if (cur) cur->addChild(cnode);
+                    else if (maxFamilies > 0 && genFamilies >= maxFamilies) hidden = true;
+                    else {
+                        ++genFamilies;
+                        FamilyPair* np = FamilyPair::create(pairArena[nextSide], f, m);
+                        np->addChild(cnode);
+                        pairIndex.insert(f, m, np);
+                        if (!head) head = tail = np;
+                        else { tail->setNext(np); tail = np; }
+                    }
+                }
+            }
+            return;
+        }
+
+        if (!sliceArenas) {
+            sliceArenas = new Arena[WorkSplitter::MAX_WORKERS];
+            slicePairs = new PairIndex[WorkSplitter::MAX_WORKERS];
+        }
+        FamilyPair* sliceHead[WorkSplitter::MAX_WORKERS];
+        int slices = WorkSplitter::slices(childCount, DISCOVERY_GRAIN);
+        WorkSplitter::runSlices(childCount, DISCOVERY_GRAIN, [&](int slice, int b, int e) {
+            Arena& arena = sliceArenas[slice];
+            PairIndex& index = slicePairs[slice];
+            arena.reset();
+            index.clear();
+            FamilyPair* h = NULL; FamilyPair* t = NULL;
+            for (int i = b; i < e; ++i) {
+                for (int ci = topo.getFirstChild(childList[i]->getPoolIndex()); ci != NONE; ci = topo.getNextSibling(ci)) {
+                    FamilyMember* f = memberAt(topo.getFather(ci));
+                    FamilyMember* m = memberAt(topo.getMother(ci));
+                    FamilyPair* cur = index.find(f, m);
+                    if (!cur) {
+                        cur = FamilyPair::create(arena, f, m);
+                        index.insert(f, m, cur);
+                        if (!h) h = t = cur; else { t->setNext(cur); t = cur; }
+                    }
+                    cur->addChild(memberPool[ci]);
+                }
+            }
+            sliceHead[slice] = h;
+        });
+
+        // merge in slice order (the serial walk's order)
+        for (int k = 0; k < slices; ++k) {
+            for (FamilyPair* lp = sliceHead[k]; lp; lp = lp->getNext()) {
+                FamilyPair* gp = pairIndex.find(lp->getFather(), lp->getMother());
+                if (!gp) {
+                    if (maxFamilies > 0 && genFamilies >= maxFamilies) { hidden = true; continue; }
+                    ++genFamilies;
+                    gp = FamilyPair::create(pairArena[nextSide], lp->getFather(), lp->getMother());
+                    pairIndex.insert(lp->getFather(), lp->getMother(), gp);
+                    if (!head) head = tail = gp; else { tail->setNext(gp); tail = gp; }
+                }
+                for (int c = 0; c < lp->getChildCount(); ++c) gp->addChild(lp->getChild(c));
+            }
+        }
+    }
+
+public:
+    FamilyTree() : memberArena(64 * 1024) { root = NULL; visitEpoch = 0; renderPairs = NULL; renderOffsets = NULL; renderPairCap = 0; renderChildStart = NULL; renderSeen = NULL; renderSeenCap = 0; sliceArenas = NULL; slicePairs = NULL; depthStale = false; queryScratch = NULL; queryScratchCap = 0; edits = editsPublished = versionCount = 0; journalPaused = false; journalLog[0] = journalSnap[0] = '\0'; journalGeneration = 0; }
+
+    ~FamilyTree() {
+        // members themselves are released with memberArena
+        if (renderPairs) { delete[] renderPairs; delete[] renderOffsets; delete[] renderChildStart; }
+        if (renderSeen) delete[] renderSeen;
+        if (sliceArenas) { delete[] sliceArenas; delete[] slicePairs; }
+        if (queryScratch) delete[] queryScratch;
+    }
+
+    bool hasRoot() const { return root != NULL; }
+
+    // ---------- Programmatic API (same rules as the interactive commands, no prompts) ----------
+    FamilyMember* getRoot() const { return root; }
+    FamilyMember* find(const char* name) { return findByName(name); }
+    void reserve(int members) { reserveMembers(members); }
+    void markLate(FamilyMember* m) { setAlive(m, false); }
+
+    // NULL if a root already exists
+    FamilyMember* createRoot(const char* name, char g, bool alive) {
+        if (root) return NULL;
+        root = createMember(name, g, alive);
+        if (journaling()) journal.log(Journal::ROOT, 0, (unsigned int)root->getPoolIndex(), 0, 0);
+        return root;
+    }
+
+    // NULL without a root or when the name is taken. The child is listed under its father,
+    // else its mother, else root (for visibility), as in addMemberInteractive.
+    FamilyMember* addMember(const char* name, char g, bool alive, FamilyMember* father, FamilyMember* mother) {
+        if (!root || findByName(name)) return NULL;
+        return linkNewMember(name, g, alive, father, mother);
+    }
+
+    // New parents for c (either may be NULL); c moves to the end of its new father's, else
+    // mother's, else root's children. Refused for root, for c as its own parent and for a
+    // parent that descends from c. Descendants' depths are updated as far as they change.
+    bool reparent(FamilyMember* c, FamilyMember* f, FamilyMember* m) {
+        if (!c || c == root || f == c || m == c || (f && f == m)) return false;
+        if ((f && isAncestor(c, f)) || (m && isAncestor(c, m))) return false;
+        bool paused = journalPaused;
+        journalPaused = true; // logged below as one record
+        relink(c, f, m, holderOf(c));
+        journalPaused = paused;
+        if (journaling()) journal.log(Journal::REPARENT, 0, (unsigned int)c->getPoolIndex(), (unsigned int)indexOf(f), (unsigned int)indexOf(m));
+        return true;
+    }
+
+    // Removes x (never root). Its children lose that parent and are re-listed the way
+    // linkNewMember lists them (under the other parent, else root). The last member moves
+    // into x's pool slot (swap-remove), so the pool stays dense and every link change is
+    // O(1) through the back links; x's storage is kept for the next createMember. Only x's
+    // own children are visited, and the render cache starts over (pool indices moved).
+    bool removeMember(FamilyMember* x) {
+        if (!x || x == root) return false;
+        FT_COUNT(MEMBERS_REMOVED, 1);
+        stats.invalidate();
+        bool paused = journalPaused;
+        journalPaused = true; // logged below as one record
+        renderCache.invalidate();
+        int xi = x->getPoolIndex();
+        for (FamilyMember* c = x->getFirstChild(); c;) {
+            FamilyMember* next = c->getNextSibling();
+            relink(c, c->getFather() == x ? NULL : c->getFather(), c->getMother() == x ? NULL : c->getMother(), x);
+            c = next;
+        }
+        for (int k = topo.getFirstCoChild(xi); k != MemberTopology::NONE;) { // x is the mother, listed under the father
+            int next = topo.getNextCoChild(k);
+            FamilyMember* c = memberPool[k];
+            relink(c, c->getFather(), NULL, c->getFather());
+            k = next;
+        }
+        FamilyMember* from = holderOf(x);
+        if (x->getPrevSibling() || from->getFirstChild() == x) detachChild(from, x);
+        setParents(x, NULL, NULL);
+
+        // the name goes to the next member with the same name, if any
+        nameOrder.remove(namePool, x->getNameOffset(), x->getNameLen(), xi);
+        if (nameIndex.remove(x)) {
+            int same = nameOrder.first(namePool, x->getName(), x->getNameLen());
+            if (same != NameTrie::NONE) nameIndex.insert(memberPool[same]);
+        }
+
+        FamilyMember* moved = memberPool[memberPool.size() - 1];
+        if (moved != x) {
+            FamilyMember* prev = moved->getPrevSibling();
+            FamilyMember* h = moved == root ? NULL : holderOf(moved);
+            if (prev) topo.setNextSibling(prev->getPoolIndex(), xi);
+            else if (h && h->getFirstChild() == moved) topo.setFirstChild(h->getPoolIndex(), xi);
+            int last = topo.removeByMove(xi);
+            nameOrder.renumber(namePool, moved->getNameOffset(), moved->getNameLen(), last, xi);
+            moved->setPoolIndex(xi);
+            memberPool[xi] = moved;
+        }
+        else topo.removeByMove(xi);
+        memberPool.pop();
+        freeMembers.push(x);
+        journalPaused = paused;
+        if (journaling()) journal.log(Journal::REMOVE, 0, (unsigned int)xi, 0, 0);
+        return true;
+    }
+
+    bool createRootInteractive() {
+        if (root) { cout << "Root already exists.\n"; return false; }
+        char name[64];
+        readLine("Enter root ancestor full name: ", name, 64);
+        if (name[0] == '\0') { cout << "Empty name. Aborted.\n"; return false; }
+        char g = readGender("Enter gender (M/F): ");
+        bool alive = readYesNoDefaultYes("Is ancestor alive? (y/n) [y]: ");
+        createRoot(name, g, alive);
+        cout << "Root '" << name << "' created.\n";
+        return true;
+    }
+
+    void addMemberInteractive() {
+        if (!root) { cout << "Create root first (option 1).\n"; return; }
+
+        char name[64];
+        readLine("Enter new member full name: ", name, 64);
+        if (name[0] == '\0') { cout << "Empty name. Aborted.\n"; return; }
+        if (findByName(name)) { cout << "Member already exists. Aborted.\n"; return; }
+
+        char gender = readGender("Enter gender (M/F): ");
+        bool alive = readYesNoDefaultYes("Is person alive? (y/n) [y]: ");
+
+        // Ask if user will provide parents
+        cout << "Do you want to specify parents for this member? (y/n): ";
+        bool specify = readYesNo(false);
+
+        FamilyMember* father = NULL;
+        FamilyMember* mother = NULL;
+
+        if (specify) {
+            char pname[64];
+            readLine("Enter father's name (or blank if unknown): ", pname, 64);
+            if (pname[0] != '\0') {
+                father = findByName(pname);
+                if (!father) {
+                    cout << "Father not found. Create father now? (y/n): ";
+                    if (readYesNo(false)) {
+                        char fg = readGender("Enter father's gender (M/F): ");
+                        bool falive = readYesNoDefaultYes("Is father alive? (y/n) [y]: ");
+                        father = createMember(pname, fg, falive);
+                        // attach to root to ensure visibility (so it's part of tree)
+                        attachChild(root, father);
+                        cout << "Father created and attached under root for visibility.\n";
+                    }
+                    else {
+                        father = NULL;
+                    }
+                }
+            }
+
+            readLine("Enter mother's name (or blank if unknown): ", pname, 64);
+            if (pname[0] != '\0') {
+                mother = findByName(pname);
+                if (!mother) {
+                    cout << "Mother not found. Create mother now? (y/n): ";
+                    if (readYesNo(false)) {
+                        char mg = readGender("Enter mother's gender (M/F): ");
+                        bool malive = readYesNoDefaultYes("Is mother alive? (y/n) [y]: ");
+                        mother = createMember(pname, mg, malive);
+                        attachChild(root, mother);
+                        cout << "Mother created and attached under root for visibility.\n";
+                    }
+                    else {
+                        mother = NULL;
+                    }
+                }
+            }
+
+            // If one parent provided and other missing, ask to create spouse optionally
+            if (father && !mother) {
+                cout << "Mother missing. Create/set mother now? (y/n): ";
+                if (readYesNo(false)) {
+                    char pname2[64];
+                    readLine("Enter mother's name: ", pname2, 64);
+                    if (pname2[0] != '\0') {
+                        FamilyMember* mnode = findByName(pname2);
+                        if (!mnode) {
+                            char mg = readGender("Enter mother's gender (M/F) [F suggested]: ");
+                            bool malive = readYesNoDefaultYes("Is mother alive? (y/n) [y]: ");
+                            mnode = createMember(pname2, mg, malive);
+                            attachChild(root, mnode);
+                        }
+                        mother = mnode;
+                    }
+                }
+            }
+            else if (mother && !father) {
+                cout << "Father missing. Create/set father now? (y/n): ";
+                if (readYesNo(false)) {
+                    char pname2[64];
+                    readLine("Enter father's name: ", pname2, 64);
+                    if (pname2[0] != '\0') {
+                        FamilyMember* mnode = findByName(pname2);
+                        if (!mnode) {
+                            char mg = readGender("Enter father's gender (M/F) [M suggested]: ");
+                            bool malive = readYesNoDefaultYes("Is father alive? (y/n) [y]: ");
+                            mnode = createMember(pname2, mg, malive);
+                            attachChild(root, mnode);
+                        }
+                        father = mnode;
+                    }
+                }
+            }
+        }
+
+        // link parents (if father not present, the child is listed under mother; with neither,
+        // under root to keep the tree connected)
+        linkNewMember(name, gender, alive, father, mother);
+        if (!father && !mother) cout << "No parents specified; member attached under root for visibility.\n";
+
+        cout << "Member '" << name << "' added successfully.\n";
+    }
+
+    void markLateInteractive() {
+        if (!root) { cout << "No tree exists.\n"; return; }
+        char name[64];
+        readLine("Enter member name to mark as Late: ", name, 64);
+        if (name[0] == '\0') { cout << "Empty name.\n"; return; }
+        FamilyMember* m = findByName(name);
+        if (!m) { cout << "Member not found.\n"; suggestNames(name); return; }
+        if (!m->isAlive()) { cout << "Already marked Late.\n"; return; }
+        cout << "Confirm marking '" << m->getName() << "' as Late? (y/n): ";
+        if (readYesNo(false)) {
+            setAlive(m, false);
+            cout << "Marked Late.\n";
+        }
+        else cout << "Cancelled.\n";
+    }
+
+    void removeMemberInteractive() {
+        if (!root) { cout << "No tree exists.\n"; return; }
+        char name[64];
+        readLine("Enter member name to remove: ", name, 64);
+        if (name[0] == '\0') { cout << "Empty name.\n"; return; }
+        FamilyMember* m = findByName(name);
+        if (!m) { cout << "Member not found.\n"; suggestNames(name); return; }
+        if (m == root) { cout << "The root ancestor cannot be removed.\n"; return; }
+        cout << "Confirm removing '" << m->getName() << "'";
+        if (m->getChildCount() > 0) cout << " (its " << m->getChildCount() << " listed children move to their other parent or root)";
+        cout << "? (y/n): ";
+        if (readYesNo(false)) {
+            removeMember(m);
+            cout << "Member '" << name << "' removed.\n";
+        }
+        else cout << "Cancelled.\n";
+    }
+
+    void reparentInteractive() {
+        if (!root) { cout << "No tree exists.\n"; return; }
+        char name[64], pname[64];
+        readLine("Enter member whose parents to change: ", name, 64);
+        FamilyMember* c = name[0] ? findByName(name) : NULL;
+        if (!c) { cout << "Member not found.\n"; if (name[0]) suggestNames(name); return; }
+        if (c == root) { cout << "The root ancestor has no parents.\n"; return; }
+        FamilyMember* parent[2] = { NULL, NULL };
+        const char* prompt[2] = { "Enter new father's name (- for none): ", "Enter new mother's name (- for none): " };
+        for (int k = 0; k < 2; ++k) {
+            readLine(prompt[k], pname, 64);
+            if (pname[0] == '\0' || (pname[0] == '-' && pname[1] == '\0')) continue;
+            parent[k] = findByName(pname);
+            if (!parent[k]) { cout << "Member not found.\n"; suggestNames(pname); return; }
+        }
+        if (!reparent(c, parent[0], parent[1])) {
+            cout << "Not changed: a member cannot be their own parent or ancestor, and father and mother must differ.\n";
+            return;
+        }
+        cout << "Parents of '" << c->getName() << "' updated.\n";
+    }
+
+    // Build top-down generations as families:
+    // Level 0: family pairs whose parents are both NULL (i.e., top ancestors or root and spouse)
+    // Level 1: families formed by children of Level 0 families, etc.
+    // Streaming view: maxGenerations / maxFamilies (0 = no limit) cap how many generations and
+    // how many families per generation are printed. Only the printed families seed the next
+    // generation, each generation is written (and flushed) as soon as it is laid out, and at most
+    // two generations of pairs are alive at any time.
+    // The output is kept in renderCache: an unchanged tree is replayed with one write, and after
+    // a mutation only the generations from the first affected one onwards are rebuilt.
+    void showCenteredTree(int maxGenerations = 0, int maxFamilies = 0) {
+        if (!root) { cout << "No tree. Create root first.\n"; return; }
+        renderTree(cout, maxGenerations, maxFamilies);
+    }
+
+    // showCenteredTree into any stream (a null one just brings the cache up to date)
+    void renderTree(ostream& os, int maxGenerations = 0, int maxFamilies = 0) {
+        bool streaming = maxGenerations > 0 || maxFamilies > 0;
+
+        RenderCache& cache = renderCache;
+        bool reuse = cache.matches(maxGenerations, maxFamilies);
+        FT_COUNT(RENDERS, 1);
+        if (reuse && cache.isClean()) {
+            FT_COUNT(RENDER_REPLAYS, 1);
+            cache.writeTo(os, 0, cache.size());
+            if (streaming) os.flush();
+            return;
+        }
+        int generation = reuse ? cache.restartAt() : 0;
+
+        // Pairs of the generation being printed live in pairArena[side], the next one is built in the other arena.
+        int side = 0;
+        pairArena[0].reset(); pairArena[1].reset();
+        bool hiddenFamilies = false; // some were dropped by maxFamilies
+        FamilyPair* currentGen = NULL;
+
+        if (generation > 0) {
+            // replay the unchanged generations, then rebuild from the seeds of the one before
+            FT_COUNT(RENDER_RESTARTS, 1);
+            cache.truncate(generation);
+            cache.writeTo(os, 0, cache.size());
+            int n = 0;
+            FamilyMember** seeds = cache.seedsOf(generation - 1, n);
+            FamilyPair* tail = NULL;
+            int genFamilies = 0;
+            groupChildren(seeds, n, side, maxFamilies, currentGen, tail, genFamilies, hiddenFamilies);
+        }
+        else {
+            cache.begin(maxGenerations, maxFamilies, memberPool.size());
+
+            currentGen = firstGeneration(side, maxFamilies, hiddenFamilies);
+
+            static const char HEADER[] = "\n=== CENTERED FAMILY TREE ===\n\n";
+            cache.put(HEADER, (int)sizeof(HEADER) - 1);
+            cache.writeTo(os, 0, cache.size());
+        }
+
+        while (currentGen != NULL) {
+            FT_CLOCK(genClock);
+            int genBegin = cache.beginGeneration();
+
+            int count = writeGeneration(currentGen, cache.buffer());
+            FamilyPair** pairs = renderPairs;
+
+            if (hiddenFamilies) {
+                static const char HIDDEN[] = "(more families in this generation not shown)\n\n";
+                cache.put(HIDDEN, (int)sizeof(HIDDEN) - 1);
+            }
+            if (maxGenerations > 0 && generation + 1 >= maxGenerations) {
+                bool deeper = false;
+                for (int i = 0; i < count; ++i)
+                    for (int k = 0; k < pairs[i]->getChildCount(); ++k) {
+                        FamilyMember* ch = pairs[i]->getChild(k);
+                        cache.notePrinted(ch->getPoolIndex(), generation); // a first child would add the note
+                        if (ch->getFirstChild()) deeper = true;
+                    }
+                if (deeper) {
+                    static const char DEEPER[] = "(deeper generations not shown)\n\n";
+                    cache.put(DEEPER, (int)sizeof(DEEPER) - 1);
+                }
+                cache.writeTo(os, genBegin, cache.size());
+                if (streaming) os.flush();
+                FT_GENERATION_DONE(generation, genClock);
+                break;
+            }
+            cache.writeTo(os, genBegin, cache.size());
+            if (streaming) os.flush(); // streaming view: emit as we go
+
+            // build next generation: families where parents are members listed in children of these
+            // families. The distinct children are kept in the cache as this generation's seeds.
+            int childCount = collectChildren(pairs, count);
+            cache.addSeeds(renderChildren.data(), childCount);
+            FamilyPair* nextGenHead = NULL; FamilyPair* nextGenTail = NULL;
+            int genFamilies = 0;
+            groupChildren(renderChildren.data(), childCount, 1 - side, maxFamilies, nextGenHead, nextGenTail, genFamilies, hiddenFamilies);
+
+            FT_GENERATION_DONE(generation, genClock);
+
+            // release current generation family pairs in one step and move to next
+            pairArena[side].reset();
+            side = 1 - side;
+            currentGen = nextGenHead;
+            generation++;
+        }
+
+        cache.endGenerations();
+        static const char FOOTER[] = "=== END OF TREE ===\n";
+        int footerBegin = cache.size();
+        cache.put(FOOTER, (int)sizeof(FOOTER) - 1);
+        cache.writeTo(os, footerBegin, cache.size());
+    }
+
+    // Streaming view with user-chosen limits (see showCenteredTree)
+    void showLimitedTreeInteractive() {
+        if (!root) { cout << "No tree. Create root first.\n"; return; }
+        int gens = readNumber("Generations to show (0 = all): ");
+        int fams = readNumber("Families per generation (0 = all): ");
+        showCenteredTree(gens, fams);
+    }
+
+    // Writes the tree as JSON (dot = false) or Graphviz DOT to os; false without a root or if
+    // the stream failed.
+    bool exportTo(ostream& os, bool dot) {
+        if (!root) return false;
+        ExportStream out(os);
+        if (dot) { DotFamilies backend(out, memberPool.size()); walkFamilies(backend); }
+        else { JsonFamilies backend(out); walkFamilies(backend); }
+        return out.finish();
+    }
+
+    // exportTo a file, "-" for standard output
+    bool exportTree(const char* path, bool dot, bool report = true) {
+        if (!root) { cout << "No tree to export.\n"; return false; }
+        bool toStdout = path[0] == '-' && path[1] == '\0';
+        ofstream file;
+        if (!toStdout) {
+            file.open(path, ios::binary | ios::trunc);
+            if (!file) { cout << "Cannot open '" << path << "' for writing.\n"; return false; }
+        }
+        if (!exportTo(toStdout ? cout : file, dot)) { cout << "Write to '" << path << "' failed.\n"; return false; }
+        if (report && !toStdout) cout << "Exported " << memberPool.size() << " members to '" << path << "' (" << (dot ? "DOT" : "JSON") << ").\n";
+        return true;
+    }
+
+    void exportInteractive() {
+        if (!root) { cout << "No tree to export.\n"; return; }
+        char format[16], path[256];
+        readLine("Format (json/dot): ", format, 16);
+        bool dot = lowerEq(format, "dot");
+        if (!dot && !lowerEq(format, "json")) { cout << "Unknown format. Aborted.\n"; return; }
+        readLine("Enter file to export to: ", path, 256);
+        if (path[0] == '\0') { cout << "Empty file name.\n"; return; }
+        exportTree(path, dot);
+    }
+
+    // ---------- Focused view ----------
+    // Next focused generation: the children each seed is the father or mother of (its own
+    // chain, less root's visibility attachments, then the children chained under it as their
+    // mother), each once, grouped by parent pair in order of first appearance in pairArena[side].
+    FamilyPair* groupOwnChildren(FamilyMember** seeds, int seedCount, int side) {
+        const int NONE = MemberTopology::NONE;
+        unsigned int seen = nextVisitEpoch();
+        pairIndex.clear();
+        FamilyPair* head = NULL; FamilyPair* tail = NULL;
+        for (int i = 0; i < seedCount; ++i) {
+            int p = seeds[i]->getPoolIndex();
+            for (int pass = 0; pass < 2; ++pass) { // listed children, then co-children
+                int c = pass == 0 ? topo.getFirstChild(p) : topo.getFirstCoChild(p);
+                for (; c != NONE; c = pass == 0 ? topo.getNextSibling(c) : topo.getNextCoChild(c)) {
+                    if (topo.getFather(c) != p && topo.getMother(c) != p) continue; // root's visibility list
+                    FamilyMember* ch = memberPool[c];
+                    if (!ch->markVisited(seen)) continue;
+                    FamilyMember* f = memberAt(topo.getFather(c));
+                    FamilyMember* m = memberAt(topo.getMother(c));
+                    FamilyPair* cur = pairIndex.find(f, m);
+                    if (!cur) {
+                        cur = FamilyPair::create(pairArena[side], f, m);
+                        pairIndex.insert(f, m, cur);
+                        if (!head) head = tail = cur; else { tail->setNext(cur); tail = cur; }
+                    }
+                    cur->addChild(ch);
+                }
+            }
+        }
+        return head;
+    }
+
+    // The family blocks around one member: up rows of its ancestors (each row lists only the
+    // members of the line, under their parents), the member under its own parents, then down
+    // generations of its descendants. Ancestors are collected level by level from the member
+    // and descendants generation by generation from the previous row's children, so only the
+    // visible window is walked and laid out and the cost follows the output, not the tree.
+    void showFocusedTree(FamilyMember* x, int up, int down) {
+        LineBuffer out;
+        static const char HEADER[] = "\n=== FAMILY TREE AROUND '";
+        static const char HEADER_END[] = "' ===\n\n";
+        out.put(HEADER, (int)sizeof(HEADER) - 1);
+        out.put(x->getName(), x->getNameLen());
+        out.put(HEADER_END, (int)sizeof(HEADER_END) - 1);
+
+        // line[levelStart[k] .. levelStart[k + 1]) = ancestors first reached k generations up;
+        // both grow as levels are found, so a large up costs nothing beyond the real line
+        int lineCap = 16, lineCount = 1, levels = 1, levelCap = 16;
+        FamilyMember** line = new FamilyMember * [lineCap];
+        int* levelStart = new int[levelCap];
+        unsigned int seen = nextVisitEpoch();
+        line[0] = x;
+        x->markVisited(seen);
+        levelStart[0] = 0; levelStart[1] = 1;
+        for (int k = 1; k <= up; ++k) {
+            for (int i = levelStart[k - 1]; i < levelStart[k]; ++i) {
+                FamilyMember* parent[2] = { line[i]->getFather(), line[i]->getMother() };
+                for (int j = 0; j < 2; ++j) {
+                    if (!parent[j] || !parent[j]->markVisited(seen)) continue;
+                    if (lineCount == lineCap) {
+                        FamilyMember** tmp = new FamilyMember * [lineCap * 2];
+                        for (int t = 0; t < lineCount; ++t) tmp[t] = line[t];
+                        delete[] line;
+                        line = tmp;
+                        lineCap *= 2;
+                    }
+                    line[lineCount++] = parent[j];
+                }
+            }
+            if (lineCount == levelStart[k]) break; // nobody further up
+            if (k + 1 == levelCap) {
+                int* tmp = new int[levelCap * 2];
+                for (int t = 0; t < levelCap; ++t) tmp[t] = levelStart[t];
+                delete[] levelStart;
+                levelStart = tmp;
+                levelCap *= 2;
+            }
+            levelStart[k + 1] = lineCount;
+            levels = k + 1;
+        }
+        bool earlier = false;
+        if (levels - 1 == up)
+            for (int i = levelStart[up]; i < levelStart[up + 1] && !earlier; ++i)
+                earlier = line[i]->getFather() || line[i]->getMother();
+        if (earlier) {
+            static const char EARLIER[] = "(earlier generations not shown)\n\n";
+            out.put(EARLIER, (int)sizeof(EARLIER) - 1);
+        }
+
+        // ancestor rows, top row first, ending with the member's own family block
+        pairArena[0].reset(); pairArena[1].reset();
+        for (int k = levels - 1; k >= 0; --k) {
+            pairArena[0].reset();
+            pairIndex.clear();
+            FamilyPair* head = NULL; FamilyPair* tail = NULL;
+            for (int i = levelStart[k]; i < levelStart[k + 1]; ++i) {
+                FamilyMember* f = line[i]->getFather();
+                FamilyMember* m = line[i]->getMother();
+                FamilyPair* cur = pairIndex.find(f, m);
+                if (!cur) {
+                    cur = FamilyPair::create(pairArena[0], f, m);
+                    pairIndex.insert(f, m, cur);
+                    if (!head) head = tail = cur; else { tail->setNext(cur); tail = cur; }
+                }
+                cur->addChild(line[i]);
+            }
+            writeGeneration(head, out);
+        }
+        delete[] line;
+        delete[] levelStart;
+
+        // descendant rows, each discovered from the distinct children printed in the row before
+        FamilyMember* focus[1] = { x };
+        FamilyMember** seeds = focus;
+        int seedCount = 1, side = 1;
+        bool deeper = false;
+        for (int d = 0; ; ++d) {
+            pairArena[side].reset();
+            FamilyPair* head = groupOwnChildren(seeds, seedCount, side);
+            deeper = head != NULL;
+            if (!deeper || d == down) break;
+            int count = writeGeneration(head, out);
+            seedCount = collectChildren(renderPairs, count);
+            seeds = renderChildren.data();
+            side = 1 - side;
+        }
+        if (deeper) {
+            static const char DEEPER[] = "(deeper generations not shown)\n\n";
+            out.put(DEEPER, (int)sizeof(DEEPER) - 1);
+        }
+        static const char FOOTER[] = "=== END OF TREE ===\n";
+        out.put(FOOTER, (int)sizeof(FOOTER) - 1);
+        out.flushTo(cout);
+    }
+
+    void showFocusedTreeInteractive() {
+        if (!root) { cout << "No tree. Create root first.\n"; return; }
+        char name[64];
+        readLine("Enter member name: ", name, 64);
+        if (name[0] == '\0') { cout << "Empty name.\n"; return; }
+        FamilyMember* m = findByName(name);
+        if (!m) { cout << "Member not found.\n"; suggestNames(name); return; }
+        int up = readNumber("Generations above: ");
+        int down = readNumber("Generations below: ");
+        showFocusedTree(m, up, down);
+    }
+
+    // ---------- Lineage queries ----------
+    // Ancestry follows the father/mother links only (attachments under root "for visibility"
+    // are not ancestry). Generation depth is 0 for members without parents, otherwise one
+    // more than the deeper parent. Result arrays must hold memberCount() entries; gens, when
+    // given, receives each result's distance in generations (1 = parent / child).
+    int memberCount() const { return memberPool.size(); }
+
+    int generationOf(const FamilyMember* m) {
+        ensureDepths();
+        return topo.getDepth(m->getPoolIndex());
+    }
+
+    bool isAncestor(const FamilyMember* a, const FamilyMember* d) {
+        ensureLineage(false);
+        return lineage.isAncestor(topo, a->getPoolIndex(), d->getPoolIndex());
+    }
+
+    int ancestorsOf(const FamilyMember* m, FamilyMember** out, int* gens = NULL, int maxGenerations = 0) {
+        ensureLineage(false);
+        int n = lineage.ancestors(topo, m->getPoolIndex(), maxGenerations, queryScratch, gens);
+        for (int i = 0; i < n; ++i) out[i] = memberPool[queryScratch[i]];
+        return n;
+    }
+
+    int descendantsOf(const FamilyMember* m, FamilyMember** out, int* gens = NULL, int maxGenerations = 0) {
+        ensureLineage(true);
+        int n = lineage.descendants(m->getPoolIndex(), maxGenerations, queryScratch, gens);
+        for (int i = 0; i < n; ++i) out[i] = memberPool[queryScratch[i]];
+        return n;
+    }
+
+    // Whole-tree numbers (see TreeStats). The first call, and the first after an edit that
+    // could not be followed, sweeps the topology once; otherwise the kept numbers are returned.
+    const TreeStats& statistics() {
+        if (!stats.isValid()) sweepStatistics();
+        return stats;
+    }
+
+    void showStatistics() {
+        if (!root) { cout << "No tree. Create root first.\n"; return; }
+        statistics().print(cout);
+    }
+
+    // Closest common ancestor of x and y, NULL when unrelated (see LineageIndex::relate).
+    // upX / upY are the generations from each member up to it; shared is 2 when a couple is
+    // shared at that distance (full siblings / cousins), 1 for a half relation.
+    FamilyMember* relationship(const FamilyMember* x, const FamilyMember* y, int& upX, int& upY, int& shared) {
+        ensureLineage(false);
+        return memberAt(lineage.relate(topo, x->getPoolIndex(), y->getPoolIndex(), upX, upY, shared));
+    }
+
+    // "great-" repeated (n - 1) times before the last step; n = 1 prints nothing
+    static void printGreats(int n) {
+        if (n > 3) cout << n - 1 << "x great-";
+        else for (int i = 1; i < n; ++i) cout << "great-";
+    }
+
+    static void printOrdinal(int n) {
+        static const char* words[] = { "first", "second", "third", "fourth", "fifth",
+                                       "sixth", "seventh", "eighth", "ninth", "tenth" };
+        if (n <= 10) { cout << words[n - 1]; return; }
+        int t = n % 100;
+        cout << n << ((t >= 11 && t <= 13) ? "th" : n % 10 == 1 ? "st" : n % 10 == 2 ? "nd" : n % 10 == 3 ? "rd" : "th");
+    }
+
+    // kinship term for x as seen from y, given both distances to the common ancestor
+    static void printRelation(const FamilyMember* x, int ux, int uy, int shared) {
+        bool male = x->getGender() == 'M';
+        if (ux == 0 && uy == 0) { cout << "the same person as"; return; }
+        if (shared == 1 && ux == 1 && uy == 1) cout << "the half-";
+        else cout << "the ";
+        if (ux == 0) { // x is y's ancestor
+            if (uy >= 3) printGreats(uy - 1);
+            if (uy >= 2) cout << "grand";
+            cout << (male ? "father" : "mother");
+        }
+        else if (uy == 0) { // x is y's descendant
+            if (ux >= 3) printGreats(ux - 1);
+            if (ux >= 2) cout << "grand";
+            cout << (male ? "son" : "daughter");
+        }
+        else if (ux == 1 && uy == 1) cout << (male ? "brother" : "sister");
+        else if (ux == 1) { // sibling of one of y's ancestors
+            printGreats(uy - 1);
+            cout << (male ? "uncle" : "aunt");
+        }
+        else if (uy == 1) { // descendant of one of y's siblings
+            printGreats(ux - 1);
+            cout << (male ? "nephew" : "niece");
+        }
+        else {
+            int degree = (ux < uy ? ux : uy) - 1, removed = ux > uy ? ux - uy : uy - ux;
+            printOrdinal(degree);
+            cout << " cousin";
+            if (removed == 1) cout << " once removed";
+            else if (removed == 2) cout << " twice removed";
+            else if (removed > 2) cout << " " << removed << " times removed";
+        }
+        if (shared == 1 && ux > 0 && uy > 0 && !(ux == 1 && uy == 1)) cout << " (half relation)";
+        cout << " of";
+    }
+
+    void showRelationshipInteractive() {
+        if (!root) { cout << "No tree exists.\n"; return; }
+        char a[64], b[64];
+        readLine("Enter first member name: ", a, 64);
+        FamilyMember* x = a[0] ? findByName(a) : NULL;
+        if (!x) { cout << "Member not found.\n"; if (a[0]) suggestNames(a); return; }
+        readLine("Enter second member name: ", b, 64);
+        FamilyMember* y = b[0] ? findByName(b) : NULL;
+        if (!y) { cout << "Member not found.\n"; if (b[0]) suggestNames(b); return; }
+        int ux, uy, shared;
+        FamilyMember* anc = relationship(x, y, ux, uy, shared);
+        if (!anc) { cout << "'" << x->getName() << "' and '" << y->getName() << "' share no recorded ancestor.\n"; return; }
+        cout << "'" << x->getName() << "' is ";
+        printRelation(x, ux, uy, shared);
+        cout << " '" << y->getName() << "'.\n";
+        if (ux > 0 && uy > 0)
+            cout << "Closest common ancestor: '" << anc->getName() << "' (" << ux << " up from '" << x->getName()
+                 << "', " << uy << " up from '" << y->getName() << "').\n";
+    }
+
+    void showLineageInteractive() {
+        if (!root) { cout << "No tree exists.\n"; return; }
+        char name[64];
+        readLine("Enter member name: ", name, 64);
+        if (name[0] == '\0') { cout << "Empty name.\n"; return; }
+        FamilyMember* m = findByName(name);
+        if (!m) { cout << "Member not found.\n"; suggestNames(name); return; }
+        FamilyMember** found = new FamilyMember * [memberPool.size()];
+        int* gens = new int[memberPool.size()];
+        cout << "'" << m->getName() << "' is in generation " << generationOf(m) << ".\n";
+        for (int pass = 0; pass < 2; ++pass) {
+            int n = pass == 0 ? ancestorsOf(m, found, gens) : descendantsOf(m, found, gens);
+            cout << (pass == 0 ? "Ancestors" : "Descendants") << " (" << n << "):";
+            if (n == 0) cout << " none";
+            cout << "\n";
+            for (int i = 0; i < n; ++i)
+                cout << "  " << found[i]->getName() << " (" << gens[i] << (pass == 0 ? " up" : " down") << ")\n";
+        }
+        delete[] found;
+        delete[] gens;
+    }
+
+    // ---------- Snapshot (binary save / load) ----------
+    // Layout (native byte order, 32-bit words, every field 4-byte aligned):
+    //   header : magic "FTSNAP1\0", version, memberCount, rootIndex, nameBytes, generation
+    //            (journal checkpoint number, 0 for a plain save)
+    //   members: memberCount records of SNAP_FIELDS words
+    //            nameOffset, father, mother, firstChild, lastChild, nextSibling, childCount, flags
+    //   names  : nameBytes of NUL-terminated names
+    // Links are member indices (SNAP_NONE = no link), so the file holds no pointers and can be
+    // used in place: loading maps it (one read where FT_POSIX_IO is not available) and makes
+    // one linear pass over the mapping that rebuilds the pointers.
+    static const unsigned int SNAP_VERSION = 1;
+    static const unsigned int SNAP_NONE = 0xFFFFFFFFu;
+    static const int SNAP_HEADER = 28;  // bytes
+    static const int SNAP_FIELDS = 8;   // words per member record
+    static const unsigned int SNAP_MALE = 1u, SNAP_ALIVE = 2u;
+
+    static unsigned int snapIndex(const FamilyMember* m) {
+        return m ? (unsigned int)m->getPoolIndex() : SNAP_NONE;
+    }
+
+    // the member table shared by snapshots and published images (SNAP_FIELDS words per member)
+    void putMemberRecords(LineBuffer& out) const {
+        auto putWord = [&](unsigned int w) { out.put((const char*)&w, 4); };
+        for (int i = 0; i < memberPool.size(); ++i) {
+            const FamilyMember* m = memberPool[i];
+            putWord((unsigned int)m->getNameOffset());
+            putWord(snapIndex(m->getFather()));
+            putWord(snapIndex(m->getMother()));
+            putWord(snapIndex(m->getFirstChild()));
+            putWord(snapIndex(m->getLastChild()));
+            putWord(snapIndex(m->getNextSibling()));
+            putWord((unsigned int)m->getChildCount());
+            putWord((m->getGender() == 'M' ? SNAP_MALE : 0u) | (m->isAlive() ? SNAP_ALIVE : 0u));
+        }
+    }
+
+    bool saveSnapshot(const char* path, bool report = true, unsigned int generation = 0) {
+        if (!root) { cout << "No tree to save.\n"; return false; }
+        static_assert(sizeof(unsigned int) == 4, "snapshot words are 32-bit");
+
+        // the interned name pool is the snapshot's name table, offsets included
+        unsigned int nameBytes = ((unsigned int)namePool.size() + 3u) & ~3u; // keep the file length word-aligned
+
+        LineBuffer out;
+        out.reserve(SNAP_HEADER + memberPool.size() * SNAP_FIELDS * 4 + (int)nameBytes);
+        auto putWord = [&](unsigned int w) { out.put((const char*)&w, 4); };
+        out.put("FTSNAP1", 8);
+        putWord(SNAP_VERSION);
+        putWord((unsigned int)memberPool.size());
+        putWord(snapIndex(root));
+        putWord(nameBytes);
+        putWord(generation);
+
+        putMemberRecords(out);
+        out.put(namePool.data(), namePool.size());
+        out.fill('\0', SNAP_HEADER + memberPool.size() * SNAP_FIELDS * 4 + (int)nameBytes - out.size());
+
+        ofstream file(path, ios::binary | ios::trunc);
+        if (!file) { cout << "Cannot open '" << path << "' for writing.\n"; return false; }
+        out.flushTo(file);
+        if (!file) { cout << "Write to '" << path << "' failed.\n"; return false; }
+        if (report) cout << "Saved " << memberPool.size() << " members to '" << path << "'.\n";
+        return true;
+    }
+
+    // ---------- Read-only images (see TreeImage): files for other processes, versions for threads ----------
+    // the whole image in out (needs a root); false if it would not fit in 2 GB
+    bool buildImage(LineBuffer& out) {
+        static_assert(TreeImage::FIELDS == SNAP_FIELDS && TreeImage::NONE == SNAP_NONE
+            && TreeImage::MALE == SNAP_MALE && TreeImage::ALIVE == SNAP_ALIVE, "image records are snapshot records");
+        ensureLineage(true);
+        if (!renderCache.matches(0, 0) || !renderCache.isClean()) { // only the cached text is wanted
+            ostream none(NULL);
+            renderTree(none);
+        }
+        int count = memberPool.size();
+        const int* rowStart = lineage.rowStarts();
+        const int* kids = lineage.rowKids();
+        unsigned int kidCount = (unsigned int)rowStart[count];
+        unsigned int slotCount = TreeImage::slotsFor(count);
+        long long total = TreeImage::sizeFor((unsigned int)count, (unsigned int)namePool.size(), slotCount, kidCount,
+                                             (unsigned int)renderCache.size());
+        if (total > 0x7FFFFFFFLL) { cout << "Tree too large to publish (" << total << " bytes).\n"; return false; }
+
+        out.truncate(0);
+        out.reserve((int)total);
+        auto putWord = [&](unsigned int w) { out.put((const char*)&w, 4); };
+        out.put("FTIMAGE1", 8);
+        putWord(TreeImage::VERSION);
+        putWord((unsigned int)count);
+        putWord(snapIndex(root));
+        putWord((unsigned int)namePool.size());
+        putWord(slotCount);
+        putWord(kidCount);
+        putWord((unsigned int)renderCache.size());
+        putWord(0);
+        putMemberRecords(out);
+        for (int i = 0; i < count; ++i) putWord((unsigned int)topo.getDepth(i));
+        for (int i = 0; i <= count; ++i) putWord((unsigned int)rowStart[i]);
+        for (unsigned int k = 0; k < kidCount; ++k) putWord((unsigned int)kids[k]);
+        // name slots, filled in place: each name goes to the member the live index returns
+        unsigned int* slots = (unsigned int*)out.extend((int)slotCount * 4);
+        for (unsigned int k = 0; k < slotCount; ++k) slots[k] = TreeImage::NONE;
+        for (int i = 0; i < count; ++i) {
+            FamilyMember* m = memberPool[i];
+            if (nameIndex.find(m->getName(), m->getNameLen(), m->getNameHash()) != m) continue;
+            unsigned int k = m->getNameHash() & (slotCount - 1);
+            while (slots[k] != TreeImage::NONE) k = (k + 1) & (slotCount - 1);
+            slots[k] = (unsigned int)i;
+        }
+        out.put(namePool.data(), namePool.size());
+        out.fill('\0', (4 - namePool.size() % 4) % 4);
+        out.put(renderCache.buffer().data(), renderCache.size());
+        out.fill('\0', (int)total - out.size());
+        return true;
+    }
+
+    // Written to path + ".tmp" and renamed over path, so mapped readers keep their version.
+    bool publishImage(const char* path, bool report = true) {
+        if (!root) { cout << "No tree to publish.\n"; return false; }
+        LineBuffer out;
+        if (!buildImage(out)) return false;
+        int count = memberPool.size();
+        char tmp[280];
+        int n = 0;
+        while (path[n] != '\0' && n < 270) { tmp[n] = path[n]; ++n; }
+        const char* ext = ".tmp";
+        for (int i = 0; i < 5; ++i) tmp[n + i] = ext[i];
+        {
+            ofstream file(tmp, ios::binary | ios::trunc);
+            if (!file) { cout << "Cannot open '" << tmp << "' for writing.\n"; return false; }
+            out.flushTo(file);
+            if (!file) { cout << "Write to '" << tmp << "' failed.\n"; return false; }
+        }
+        if (rename(tmp, path) != 0 && !(remove(path) == 0 && rename(tmp, path) == 0)) { // no replacing rename
+            cout << "Cannot replace '" << path << "'.\n";
+            return false;
+        }
+        if (report) cout << "Published " << count << " members to '" << path << "'.\n";
+        return true;
+    }
+
+    // Reader threads (TreeReader on versions()) see the tree as of the latest publishVersion;
+    // edits go on meanwhile in the live tree. Builds and swaps in a new version when there was
+    // an edit since the last one; false if there was none (or no root).
+    VersionPublisher& versions() { return versionsOut; }
+    bool publishVersion() {
+        if (!root || (versionCount > 0 && edits == editsPublished)) return false;
+        TreeVersion* v = new TreeVersion(versionCount + 1);
+        if (!buildImage(v->buffer())) { delete v; return false; }
+        ++versionCount;
+        editsPublished = edits;
+        versionsOut.publish(v);
+        return true;
+    }
+
+    void publishInteractive() {
+        char path[256];
+        readLine("Enter image file to publish to (e.g. /dev/shm/family.img): ", path, 256);
+        if (path[0] == '\0') { cout << "Empty file name.\n"; return; }
+        publishImage(path);
+    }
+
+    // bulk paths are not journaled member by member; a checkpoint follows them instead
+    bool loadSnapshot(const char* path, unsigned int* generation = NULL) {
+        journalPaused = true;
+        bool ok = loadImage(path, generation);
+        journalPaused = false;
+        if (journal.isOpen()) checkpoint();
+        return ok;
+    }
+
+    bool importFile(const char* path) {
+        journalPaused = true;
+        bool ok = importRows(path);
+        journalPaused = false;
+        if (journal.isOpen()) checkpoint();
+        return ok;
+    }
+
+    // The whole file at path, word aligned and read-only: mapped privately where FT_POSIX_IO is
+    // available, otherwise read into a heap copy. NULL if it cannot be opened or read, or is not
+    // a whole number of words (empty included); size receives its length (-1 if it cannot be
+    // opened). Released with unmapFile.
+    static const unsigned int* mapFile(const char* path, long long& size) {
+        size = -1;
+#ifdef FT_POSIX_IO
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return NULL;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return NULL; }
+        size = (long long)st.st_size;
+        void* at = size > 0 && size % 4 == 0 ? mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd); // the mapping keeps the file
+        return at == MAP_FAILED ? NULL : (const unsigned int*)at;
+#else
+        ifstream file(path, ios::binary | ios::ate);
+        if (!file) return NULL;
+        size = (long long)file.tellg();
+        if (size <= 0 || size % 4 != 0) return NULL;
+        unsigned int* img = new unsigned int[(size_t)(size / 4)]; // word aligned
+        file.seekg(0);
+        file.read((char*)img, size);
+        if (!file) { delete[] img; return NULL; }
+        return img;
+#endif
+    }
+
+    static void unmapFile(const unsigned int* img, long long size) {
+#ifdef FT_POSIX_IO
+        munmap((void*)img, (size_t)size);
+#else
+        (void)size;
+        delete[] img;
+#endif
+    }
+
+    // generation (if given) receives the snapshot's journal checkpoint number
+    bool loadImage(const char* path, unsigned int* generation = NULL) {
+        if (root) { cout << "A tree already exists; load needs an empty session.\n"; return false; }
+        long long size;
+        const unsigned int* img = mapFile(path, size);
+        if (size < 0) { cout << "Cannot open '" << path << "'.\n"; return false; }
+        if (!img || size < SNAP_HEADER) {
+            if (img) unmapFile(img, size);
+            cout << "Not a family tree snapshot.\n";
+            return false;
+        }
+
+        // the records are used in place, straight from the mapping
+        bool ok = true;
+        const char* bytes = (const char*)img;
+        const char magic[8] = { 'F', 'T', 'S', 'N', 'A', 'P', '1', '\0' };
+        for (int i = 0; ok && i < 8; ++i) ok = bytes[i] == magic[i];
+        unsigned int count = ok ? img[3] : 0, rootIdx = ok ? img[4] : 0, nameBytes = ok ? img[5] : 0;
+        ok = ok && img[2] == SNAP_VERSION && count > 0 && count < 0x7FFFFFFFu && rootIdx < count
+            && (long long)SNAP_HEADER + (long long)count * SNAP_FIELDS * 4 + nameBytes == size;
+        const unsigned int* rec = img + SNAP_HEADER / 4;
+        const char* names = (const char*)(rec + (size_t)count * SNAP_FIELDS);
+        for (unsigned int i = 0; ok && i < count; ++i) {
+            const unsigned int* r = rec + (size_t)i * SNAP_FIELDS;
+            for (int k = 1; ok && k <= 5; ++k) ok = r[k] == SNAP_NONE || r[k] < count;
+            ok = ok && r[0] < nameBytes;
+        }
+        ok = ok && (nameBytes == 0 || names[nameBytes - 1] == '\0');
+        ok = ok && (unsigned int)namePool.size() + nameBytes < 0x7FFFFFFFu;
+        if (!ok) {
+            unmapFile(img, size);
+            cout << "Snapshot '" << path << "' is damaged or from another version.\n";
+            return false;
+        }
+
+        // the name table is copied into the pool as one block, members go into one contiguous
+        // arena block, then links are resolved by index
+        int nameBase = namePool.addBlock(names, (int)nameBytes);
+        reserveMembers((int)count);
+        FamilyMember* block = (FamilyMember*)memberArena.alloc((size_t)count * sizeof(FamilyMember));
+        for (unsigned int i = 0; i < count; ++i) {
+            const unsigned int* r = rec + (size_t)i * SNAP_FIELDS;
+            int len = FamilyMember::nameLength(names + r[0]); // table ends in '\0', scan is bounded
+            FamilyMember* m = new (block + i) FamilyMember(namePool, nameBase + (int)r[0], len,
+                (r[7] & SNAP_MALE) ? 'M' : 'F', (r[7] & SNAP_ALIVE) != 0);
+            poolAdd(m);
+            topo.append((r[7] & SNAP_MALE) != 0, (r[7] & SNAP_ALIVE) != 0);
+        }
+        auto at = [&](unsigned int idx) { return idx == SNAP_NONE ? (FamilyMember*)NULL : block + idx; };
+        int b = block[0].getPoolIndex(); // pool indices of the block are contiguous
+        auto idx = [&](unsigned int v) { return v == SNAP_NONE ? MemberTopology::NONE : b + (int)v; };
+        for (unsigned int i = 0; i < count; ++i) {
+            const unsigned int* r = rec + (size_t)i * SNAP_FIELDS;
+            block[i].restoreLinks(at(r[1]), at(r[2]), at(r[3]), at(r[4]), at(r[5]), (int)r[6]);
+            if (r[5] != SNAP_NONE) block[r[5]].setPrevSibling(block + i);
+            topo.setParents(b + (int)i, idx(r[1]), idx(r[2]));
+            topo.setFirstChild(b + (int)i, idx(r[3]));
+            topo.setNextSibling(b + (int)i, idx(r[5]));
+        }
+        depthStale = true;
+        stats.invalidate();
+        lineage.invalidate();
+        renderCache.invalidate();
+        root = block + rootIdx;
+        ++edits;
+        if (generation) *generation = img[6];
+        unmapFile(img, size);
+        cout << "Loaded " << count << " members from '" << path << "'.\n";
+        return true;
+    }
+
+    void saveInteractive() {
+        char path[256];
+        readLine("Enter file to save to: ", path, 256);
+        if (path[0] == '\0') { cout << "Empty file name.\n"; return; }
+        saveSnapshot(path);
+    }
+
+    void loadInteractive() {
+        char path[256];
+        readLine("Enter file to load: ", path, 256);
+        if (path[0] == '\0') { cout << "Empty file name.\n"; return; }
+        loadSnapshot(path);
+    }
+
+    // ---------- Batch import (CSV / TSV) ----------
+    // One member per line: name,gender,alive,father,mother (a line containing a tab is split on
+    // tabs instead). gender is M/F, alive is y/n (also 1/0, yes/no, true/false; blank = y), parent
+    // columns may be blank. A first line whose first field is "name" is taken as a header.
+    // Parents may be defined anywhere in the file (or already be in the tree): members are created
+    // in a first pass and parent names are resolved in a second one. Unknown parents are
+    // auto-created under root, exactly like addMemberInteractive does.
+    static const int IMPORT_LINE = 1024;
+    static const int IMPORT_FIELDS = 5;
+    static const int IMPORT_MAX_REPORTS = 10; // per-row messages printed before going quiet
+
+    // split line in place; fields are trimmed (handles CRLF files), returns number of fields
+    static int splitRow(char* line, char** fields, int maxFields) {
+        char sep = ',';
+        for (int i = 0; line[i] != '\0'; ++i) if (line[i] == '\t') { sep = '\t'; break; }
+        int n = 0;
+        char* p = line;
+        while (n < maxFields) {
+            while (*p == ' ' || (sep != '\t' && *p == '\t')) ++p;
+            fields[n++] = p;
+            while (*p != '\0' && *p != sep) ++p;
+            char* end = p;
+            while (end > fields[n - 1] && (end[-1] == ' ' || end[-1] == '\r' || end[-1] == '\t')) --end;
+            bool last = (*p == '\0');
+            *end = '\0';
+            if (last) break;
+            ++p;
+        }
+        for (int i = n; i < maxFields; ++i) fields[i] = p; // missing columns read as blank
+        return n;
+    }
+
+    static bool lowerEq(const char* a, const char* b) {
+        int i = 0;
+        for (; a[i] != '\0' && b[i] != '\0'; ++i) {
+            char c = (a[i] >= 'A' && a[i] <= 'Z') ? (char)(a[i] - 'A' + 'a') : a[i];
+            if (c != b[i]) return false;
+        }
+        return a[i] == b[i];
+    }
+
+    // -1 = invalid
+    static int parseAlive(const char* v) {
+        if (v[0] == '\0' || lowerEq(v, "y") || lowerEq(v, "yes") || lowerEq(v, "1") || lowerEq(v, "true")) return 1;
+        if (lowerEq(v, "n") || lowerEq(v, "no") || lowerEq(v, "0") || lowerEq(v, "false") || lowerEq(v, "late")) return 0;
+        return -1;
+    }
+
+    // keep field lookups consistent with FamilyMember's 63-char name storage
+    static void clipName(char* n) {
+        int i = 0;
+        while (n[i] != '\0' && i < 63) ++i;
+        n[i] = '\0';
+    }
+
+    bool importRows(const char* path) {
+        ifstream file(path, ios::binary);
+        if (!file) { cout << "Cannot open '" << path << "'.\n"; return false; }
+
+        // pass 0: count lines so the pool and the row table are sized once
+        int rows = 0;
+        {
+            char chunk[64 * 1024];
+            bool partial = false;
+            while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+                int got = (int)file.gcount();
+                for (int i = 0; i < got; ++i) if (chunk[i] == '\n') ++rows;
+                partial = chunk[got - 1] != '\n';
+            }
+            if (partial) ++rows;
+        }
+        if (rows == 0) { cout << "File is empty.\n"; return false; }
+        reserveMembers(memberPool.size() + rows);
+        FamilyMember** rowMember = new FamilyMember * [rows];
+        for (int i = 0; i < rows; ++i) rowMember[i] = NULL;
+
+        char line[IMPORT_LINE];
+        char* fld[IMPORT_FIELDS];
+        int reports = 0, skipped = 0, created = 0, autoParents = 0, cut = 0;
+        auto report = [&](int row, const char* what) {
+            if (reports++ < IMPORT_MAX_REPORTS) cout << "  line " << row + 1 << ": " << what << "\n";
+        };
+        auto rewind = [&]() { file.clear(); file.seekg(0); };
+        auto nextRow = [&](int& row) -> bool {
+            if (row + 1 >= rows) return false;
+            ++row;
+            file.getline(line, IMPORT_LINE);
+            if (file.fail() && !file.eof()) { // over-long line: keep the prefix, drop the rest
+                file.clear();
+                file.ignore((streamsize)1 << 30, '\n');
+            }
+            return true;
+        };
+        int preCount = memberPool.size();
+
+        // pass 1: create members in file order
+        rewind();
+        for (int row = -1; nextRow(row);) {
+            int n = splitRow(line, fld, IMPORT_FIELDS);
+            if (n == 1 && fld[0][0] == '\0') continue; // blank line
+            if (row == 0 && lowerEq(fld[0], "name")) continue;
+            clipName(fld[0]);
+            if (fld[0][0] == '\0') { report(row, "empty name, skipped"); ++skipped; continue; }
+            char g = fld[1][0];
+            if (fld[1][1] != '\0' || !(g == 'M' || g == 'm' || g == 'F' || g == 'f')) {
+                report(row, "gender must be M or F, skipped"); ++skipped; continue;
+            }
+            int alive = parseAlive(fld[2]);
+            if (alive < 0) { report(row, "alive must be y or n, skipped"); ++skipped; continue; }
+            if (findByName(fld[0])) { report(row, "member already exists, skipped"); ++skipped; continue; }
+            rowMember[row] = createMember(fld[0], g, alive == 1);
+            if (!root) root = rowMember[row]; // an empty session takes the first row as root
+            ++created;
+        }
+
+        // pass 2: resolve parent names (auto-creating unknown ones) and set parent pointers
+        rewind();
+        for (int row = -1; nextRow(row);) {
+            FamilyMember* c = rowMember[row];
+            if (!c || c == root) continue; // root keeps no parents
+            splitRow(line, fld, IMPORT_FIELDS);
+            FamilyMember* parent[2] = { NULL, NULL };
+            for (int k = 0; k < 2; ++k) {
+                char* pn = fld[3 + k];
+                clipName(pn);
+                if (pn[0] == '\0') continue;
+                parent[k] = findByName(pn);
+                if (!parent[k]) {
+                    parent[k] = createMember(pn, k == 0 ? 'M' : 'F', true);
+                    attachChild(root, parent[k]); // attach to root for visibility, as interactively
+                    ++autoParents;
+                }
+            }
+            setParents(c, parent[0], parent[1]);
+        }
+
+        // pass 3: file order can describe loops (A parent of B parent of A). Walk parent links
+        // (topology arrays only) depth-first from every imported member and cut any link that
+        // closes a cycle, so traversals over the tree always terminate.
+        {
+            int total = topo.size();
+            char* color = new char[total];      // 0 new, 1 on stack, 2 done
+            for (int i = 0; i < total; ++i) color[i] = i < preCount ? 2 : 0;
+            int* stack = new int[total];
+            char* edge = new char[total];       // next parent slot (0 father, 1 mother) per stack entry
+            for (int i = preCount; i < total; ++i) {
+                if (color[i]) continue;
+                int sp = 0;
+                stack[sp] = i; edge[sp] = 0; color[i] = 1; ++sp;
+                while (sp > 0) {
+                    int mi = stack[sp - 1];
+                    if (edge[sp - 1] == 2) { color[mi] = 2; --sp; continue; }
+                    int slot = edge[sp - 1]++;
+                    int pi = slot == 0 ? topo.getFather(mi) : topo.getMother(mi);
+                    if (pi == MemberTopology::NONE) continue;
+                    if (color[pi] == 1) {
+                        FamilyMember* m = memberPool[mi];
+                        if (slot == 0) setParents(m, NULL, m->getMother());
+                        else setParents(m, m->getFather(), NULL);
+                        ++cut;
+                        if (reports++ < IMPORT_MAX_REPORTS)
+                            cout << "  '" << m->getName() << "': parent '" << memberPool[pi]->getName()
+                                 << "' would make a cycle, link dropped\n";
+                    }
+                    else if (color[pi] == 0) {
+                        color[pi] = 1; stack[sp] = pi; edge[sp] = 0; ++sp;
+                    }
+                }
+            }
+            delete[] color; delete[] stack; delete[] edge;
+        }
+        depthStale = true; // pass 2 linked children before some of their parents
+        stats.invalidate();
+        renderCache.invalidate();
+
+        // pass 4: child lists in file order, same rules as addMemberInteractive
+        for (int row = 0; row < rows; ++row) {
+            FamilyMember* c = rowMember[row];
+            if (!c || c == root) continue;
+            if (c->getFather()) attachChild(c->getFather(), c);
+            else if (c->getMother()) attachChild(c->getMother(), c);
+            else attachChild(root, c);
+        }
+        delete[] rowMember;
+
+        if (reports > IMPORT_MAX_REPORTS) cout << "  ... " << reports - IMPORT_MAX_REPORTS << " more messages\n";
+        cout << "Imported " << created << " members (" << autoParents << " parents auto-created, "
+             << skipped << " rows skipped";
+        if (cut) cout << ", " << cut << " cyclic links dropped";
+        cout << ").\n";
+        return created > 0;
+    }
+
+    // ---------- Journal (write-ahead log, --journal BASE) ----------
+    // BASE.snap holds the last checkpoint and BASE.log every mutation since (see Journal).
+    // Opening recovers the snapshot and replays the log tail. Checkpoints (after a replay,
+    // import or load, and on exit) write the snapshot to a temporary file, sync it, rename it
+    // over the old one and only then truncate the log. Each checkpoint has a new number that
+    // goes into the snapshot's header and the new log's header, and a log is replayed only
+    // when its number is the snapshot's, so a crash at any point leaves a snapshot plus a log
+    // that is either its own tail or an older one already contained in it (and ignored).
+    bool openJournal(const char* base) {
+        int n = 0;
+        while (base[n] != '\0') ++n;
+        if (n == 0 || n > 255) { cout << "Journal name must be 1 to 255 characters.\n"; return false; }
+        for (int i = 0; i < n; ++i) journalLog[i] = journalSnap[i] = base[i];
+        const char* logExt = ".log";
+        const char* snapExt = ".snap";
+        for (int i = 0; i < 5; ++i) journalLog[n + i] = logExt[i];
+        for (int i = 0; i < 6; ++i) journalSnap[n + i] = snapExt[i];
+
+        ifstream probe(journalSnap, ios::binary);
+        if (probe) {
+            probe.close();
+            if (!loadSnapshot(journalSnap, &journalGeneration)) return false;
+        }
+        bool torn = false;
+        int replayed = replayJournal(journalLog, torn);
+        if (replayed > 0 || torn)
+            cout << "Replayed " << (replayed > 0 ? replayed : 0) << " journal records from '" << journalLog << "'"
+                 << (torn ? " (damaged tail dropped)" : "") << ".\n";
+        // a missing, stale or damaged log, or one that was replayed, is folded into a new checkpoint
+        if (replayed != 0 || torn) return checkpoint();
+        if (!journal.start(journalLog, (unsigned int)memberPool.size(), journalGeneration, false)) {
+            cout << "Cannot open journal '" << journalLog << "'.\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool checkpoint() {
+        if (journalLog[0] == '\0') return false;
+        journal.stop(); // everything logged so far is on disk
+        unsigned int generation = 0; // no snapshot
+        if (root) {
+            generation = journalGeneration + 1 != 0 ? journalGeneration + 1 : 1;
+            char tmp[280];
+            int n = 0;
+            for (; journalSnap[n] != '\0'; ++n) tmp[n] = journalSnap[n];
+            const char* ext = ".tmp";
+            for (int i = 0; i < 5; ++i) tmp[n + i] = ext[i];
+            bool ok = saveSnapshot(tmp, false, generation) && Journal::syncFile(tmp);
+            if (ok && rename(tmp, journalSnap) != 0) ok = remove(journalSnap) == 0 && rename(tmp, journalSnap) == 0; // no replacing rename
+            if (!ok) {
+                cout << "Checkpoint failed; still appending to '" << journalLog << "'.\n";
+                journal.start(journalLog, 0, journalGeneration, false);
+                return false;
+            }
+        }
+        else remove(journalSnap);
+        // from here on the log left behind belongs to an older number than the snapshot
+        journalGeneration = generation;
+        if (!journal.start(journalLog, (unsigned int)memberPool.size(), generation, true)) {
+            cout << "Cannot open journal '" << journalLog << "'.\n";
+            return false;
+        }
+        return true;
+    }
+
+    void closeJournal() {
+        if (journal.isOpen()) checkpoint();
+        journal.stop();
+    }
+
+    // Applies path's records in order (the journal must not be open). Returns the number
+    // applied, or -1 if there is no log or it does not follow the loaded snapshot (another
+    // checkpoint number or member count); torn is set when it ends in a partial or damaged record.
+    int replayJournal(const char* path, bool& torn) {
+        torn = false;
+        ifstream file(path, ios::binary | ios::ate);
+        if (!file) return -1;
+        long long size = (long long)file.tellg();
+        if (size < Journal::HEADER) return -1;
+        char* img = new char[(size_t)size];
+        file.seekg(0);
+        file.read(img, size);
+        unsigned int head[3];
+        for (int i = 0; i < 12; ++i) ((char*)head)[i] = img[8 + i];
+        const char magic[8] = { 'F', 'T', 'J', 'R', 'N', 'L', '1', '\0' };
+        bool ok = (bool)file && head[0] == Journal::VERSION && head[1] == (unsigned int)memberPool.size()
+            && head[2] == journalGeneration;
+        for (int i = 0; i < 8 && ok; ++i) ok = img[i] == magic[i];
+        if (!ok) { delete[] img; return -1; }
+
+        int applied = 0;
+        long long pos = Journal::HEADER;
+        while (pos < size) {
+            unsigned int w[5];
+            if (size - pos < Journal::RECORD) { torn = true; break; }
+            for (int i = 0; i < Journal::RECORD; ++i) ((char*)w)[i] = img[pos + i];
+            int rs = Journal::recordSize(w[0]);
+            if (size - pos < rs || Journal::checksum(img + pos, rs) != w[4] || !applyRecord(w, img + pos + Journal::RECORD)) {
+                torn = true;
+                break;
+            }
+            pos += rs;
+            ++applied;
+        }
+        delete[] img;
+        return applied;
+    }
+
+    // one journal record through the usual mutators; false if it does not fit the tree
+    bool applyRecord(const unsigned int* w, const char* nameBytes) {
+        unsigned int op = w[0] & 0xFFu, flags = (w[0] >> 8) & 0xFFu, len = w[0] >> 16;
+        auto valid = [&](unsigned int i) { return i < (unsigned int)memberPool.size(); };
+        auto member = [&](unsigned int i) { return i == Journal::NONE ? (FamilyMember*)NULL : memberPool[i]; };
+        if (op == Journal::CREATE) {
+            if (len == 0 || len > (unsigned int)NamePool::MAX_LEN) return false;
+            char name[NamePool::MAX_LEN + 1];
+            for (unsigned int i = 0; i < len; ++i) name[i] = nameBytes[i];
+            name[len] = '\0';
+            createMember(name, (flags & Journal::MALE) ? 'M' : 'F', (flags & Journal::IS_ALIVE) != 0);
+            return true;
+        }
+        if (op == Journal::ROOT) {
+            if (root || !valid(w[1])) return false;
+            root = memberPool[w[1]];
+            return true;
+        }
+        if (op == Journal::PARENTS) {
+            if (!valid(w[1]) || !(w[2] == Journal::NONE || valid(w[2])) || !(w[3] == Journal::NONE || valid(w[3]))) return false;
+            setParents(memberPool[w[1]], member(w[2]), member(w[3]));
+            return true;
+        }
+        if (op == Journal::ATTACH) {
+            if (!valid(w[1]) || !valid(w[2])) return false;
+            attachChild(memberPool[w[1]], memberPool[w[2]]);
+            return true;
+        }
+        if (op == Journal::ALIVE) {
+            if (!valid(w[1])) return false;
+            setAlive(memberPool[w[1]], w[2] != 0);
+            return true;
+        }
+        if (op == Journal::REPARENT) {
+            if (!valid(w[1]) || !(w[2] == Journal::NONE || valid(w[2])) || !(w[3] == Journal::NONE || valid(w[3]))) return false;
+            return reparent(memberPool[w[1]], member(w[2]), member(w[3]));
+        }
+        if (op == Journal::REMOVE) return valid(w[1]) && removeMember(memberPool[w[1]]);
+        return false;
+    }
+
+    void importInteractive() {
+        char path[256];
+        readLine("Enter CSV/TSV file (name,gender,alive,father,mother): ", path, 256);
+        if (path[0] == '\0') { cout << "Empty file name.\n"; return; }
+        importFile(path);
+    }
+
+    // ---------- Utilities: safe input ----------
+    static void readLine(const char* prompt, char* buffer, int size) {
+        cout << prompt;
+        // clear newline
+        if (cin.peek() == '\n') cin.get();
+        cin.getline(buffer, size);
+    }
+
+    static char readGender(const char* prompt) {
+        char g;
+        while (true) {
+            cout << prompt;
+            cin >> g;
+            if (g == 'M' || g == 'm' || g == 'F' || g == 'f') {
+                if (cin.peek() == '\n') cin.get();
+                return (g == 'M' || g == 'm') ? 'M' : 'F';
+            }
+            else {
+                cout << "Invalid gender. Enter M or F.\n";
+                cin.clear();
+                if (cin.peek() != '\n') cin.ignore(1000, '\n');
+            }
+        }
+    }
+
+    static int readNumber(const char* prompt) {
+        cout << prompt;
+        int n;
+        while (!(cin >> n) || n < 0) {
+            cout << "Invalid number, enter again: ";
+            cin.clear(); cin.ignore(1000, '\n');
+        }
+        if (cin.peek() == '\n') cin.get();
+        return n;
+    }
+
+    static bool readYesNo(bool defaultNo) {
+        char ch;
+        while (true) {
+            cin >> ch;
+            if (ch == 'y' || ch == 'Y') { if (cin.peek() == '\n') cin.get(); return true; }
+            if (ch == 'n' || ch == 'N') { if (cin.peek() == '\n') cin.get(); return false; }
+            cout << "Please enter y or n: ";
+            if (cin.peek() != '\n') cin.ignore(1000, '\n');
+        }
+    }
+    static bool readYesNoDefaultYes(const char* prompt) {
+        cout << prompt;
+        char ch;
+        while (true) {
+            cin >> ch;
+            if (ch == 'y' || ch == 'Y') { if (cin.peek() == '\n') cin.get(); return true; }
+            if (ch == 'n' || ch == 'N') { if (cin.peek() == '\n') cin.get(); return false; }
+            cout << "Please enter y or n: ";
+            if (cin.peek() != '\n') cin.ignore(1000, '\n');
+        }
+    }
+
+    // ---------- For Menu & testing ----------
+    // ---------- Name search ----------
+    // Members whose name starts with (prefix) or contains text, in creation order; out needs
+    // room for memberCount() entries. One scan over the name pool: each hit is widened to the
+    // name around it and mapped back through the NameIndex, then the scan resumes after that
+    // name so nobody is listed twice.
+    int searchNames(const char* text, bool prefix, FamilyMember** out) {
+        char needle[NamePool::MAX_LEN + 2];
+        int skip = prefix ? 1 : 0, n = 0;
+        if (prefix) needle[n++] = '\0'; // a prefix hit follows the previous name's terminator
+        for (int i = 0; text[i] != '\0' && n - skip < NamePool::MAX_LEN; ++i) needle[n++] = text[i];
+        if (n == skip || text[n - skip] != '\0') return 0; // empty, or longer than any name
+
+        const char* bytes = namePool.data();
+        int found = 0;
+        auto take = [&](int start) { // record the member named at start, return its terminator
+            int end = namePool.nameEnd(start);
+            FamilyMember* m = nameIndex.find(bytes + start, end - start, FamilyMember::hashName(bytes + start, end - start));
+            if (m && m->getNameOffset() == start) out[found++] = m;
+            return end;
+        };
+        int pos = 0;
+        if (prefix && namePool.size() > 0) { // the first name has no terminator before it
+            int i = 0;
+            while (i < n - 1 && bytes[i] == needle[i + 1]) ++i;
+            if (i == n - 1) pos = take(0);
+        }
+        while ((pos = namePool.findText(needle, n, pos)) >= 0)
+            pos = prefix ? take(pos + 1) : take(namePool.nameStart(pos)) + 1;
+        return found;
+    }
+
+    void searchNamesInteractive() {
+        if (!root) { cout << "No tree exists.\n"; return; }
+        char text[64];
+        readLine("Enter part of a name: ", text, 64);
+        if (text[0] == '\0') { cout << "Empty search.\n"; return; }
+        cout << "Match only the start of names? (y/n): ";
+        bool prefix = readYesNo(false);
+        printSearch(text, prefix);
+    }
+
+    void printSearch(const char* text, bool prefix) {
+        FamilyMember** found = new FamilyMember * [memberPool.size() ? memberPool.size() : 1];
+        int n = searchNames(text, prefix, found);
+        cout << "\n" << n << (n == 1 ? " member " : " members ") << (prefix ? "starting with" : "containing")
+             << " '" << text << "'" << (n ? ":" : ".") << "\n";
+        for (int i = 0; i < n; ++i) cout << "- " << found[i]->getName() << "\n";
+        delete[] found;
+    }
+
+    // ---------- Alphabetical listing ----------
+    // Members whose name starts with prefix ("" = everyone) in byte order, from the NameTrie:
+    // skips the first skip of them and writes at most max to out. No sorting per call.
+    int listByName(const char* prefix, int skip, int max, FamilyMember** out) {
+        int k = FamilyMember::nameLength(prefix);
+        int* idx = new int[max > 0 ? max : 1];
+        int n = nameOrder.page(namePool, prefix, k, skip, max, idx);
+        for (int i = 0; i < n; ++i) out[i] = memberPool[idx[i]];
+        delete[] idx;
+        return n;
+    }
+
+    int countByName(const char* prefix) {
+        return nameOrder.countPrefix(namePool, prefix, FamilyMember::nameLength(prefix));
+    }
+
+    // one page of the alphabetical listing; returns how many were printed
+    int printNamePage(const char* prefix, int skip, int max) {
+        FamilyMember** page = new FamilyMember * [max > 0 ? max : 1];
+        int n = listByName(prefix, skip, max, page);
+        for (int i = 0; i < n; ++i) cout << "- " << page[i]->getName() << "\n";
+        delete[] page;
+        return n;
+    }
+
+    // autocomplete for a name that was not found: the first few names it is a prefix of
+    void suggestNames(const char* typed) {
+        static const int SHOWN = 5;
+        int total = countByName(typed);
+        if (total == 0) return;
+        FamilyMember* hits[SHOWN];
+        int n = listByName(typed, 0, SHOWN, hits);
+        cout << "Did you mean: ";
+        for (int i = 0; i < n; ++i) cout << (i ? ", " : "") << hits[i]->getName();
+        if (total > n) cout << " (and " << total - n << " more)";
+        cout << "?\n";
+    }
+
+    void listByNameInteractive() {
+        static const int PAGE = 20;
+        if (!root) { cout << "No tree exists.\n"; return; }
+        char prefix[64];
+        readLine("Names starting with (* for all): ", prefix, 64);
+        if (prefix[0] == '*' && prefix[1] == '\0') prefix[0] = '\0';
+        int total = countByName(prefix);
+        cout << "\n" << total << (total == 1 ? " member" : " members") << " in alphabetical order:\n";
+        for (int shown = 0; shown < total; ) {
+            shown += printNamePage(prefix, shown, PAGE);
+            if (shown >= total) break;
+            cout << "Show " << (total - shown < PAGE ? total - shown : PAGE) << " more of " << total - shown << "? (y/n): ";
+            if (!readYesNo(false)) break;
+        }
+    }
+
+    void showAllNames() {
+        cout << "\nAll members:\n";
+        for (int i = 0; i < memberPool.size(); ++i) cout << "- " << memberPool[i]->getName() << "\n";
+    }
+};
+
+// -------------------------
+// Menu (short main logic)
+// -------------------------
+class Menu {
+private:
+    FamilyTree tree;
+    int readChoice() {
+        int c;
+        while (!(cin >> c)) {
+            cout << "Invalid number, enter again: ";
+            cin.clear(); cin.ignore(1000, '\n');
+        }
+        if (cin.peek() == '\n') cin.get();
+        return c;
+    }
+public:
+    static bool isFlag(const char* arg, const char* flag) {
+        int i = 0;
+        while (arg[i] == flag[i]) { if (arg[i] == '\0') return true; ++i; }
+        return false;
+    }
+
+    // first press: reset and start counting; second press: print the report and stop
+    static void toggleStats() {
+#ifdef FAMILY_TREE_STATS
+        if (!Stats::enabled) {
+            Stats::reset();
+            Stats::enabled = true;
+            cout << "Instrumentation on (counters reset). Choose 12 again for the report.\n";
+        }
+        else {
+            Stats::report(cout);
+            Stats::enabled = false;
+            cout << "Instrumentation off.\n";
+        }
+#else
+        cout << "Instrumentation is not compiled in (rebuild with -DFAMILY_TREE_STATS).\n";
+#endif
+    }
+
+    bool openJournal(const char* base) { return tree.openJournal(base); }
+    void closeJournal() { tree.closeJournal(); }
+    // background readers attach a TreeReader here; while any is attached, every command
+    // that changed the tree publishes a new version when it finishes
+    VersionPublisher& versions() { return tree.versions(); }
+
+    // next command line of a script: the command word in cmd and its n arguments in fld.
+    // Returns n, NO_COMMAND for blank, comment and over-long lines (skipped; lineNo counts
+    // them all), or END_OF_SCRIPT.
+    static const int NO_COMMAND = -1, END_OF_SCRIPT = -2;
+    static int nextCommand(istream& in, char* line, int& lineNo, char*& cmd, char** fld, bool& tooLong) {
+        tooLong = false;
+        if (in.eof()) return END_OF_SCRIPT;
+        in.getline(line, FamilyTree::IMPORT_LINE);
+        if (in.fail() && !in.eof()) { // over-long line: reject it, skip the rest
+            in.clear();
+            in.ignore((streamsize)1 << 30, '\n');
+            ++lineNo;
+            tooLong = true;
+            return NO_COMMAND;
+        }
+        if (in.eof() && line[0] == '\0') return END_OF_SCRIPT;
+        ++lineNo;
+
+        // command word, then its arguments
+        char* p = line;
+        while (*p == ' ' || *p == '\t') ++p;
+        if (*p == '\0' || *p == '#' || *p == '\r') return NO_COMMAND;
+        cmd = p;
+        while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+        if (*p != '\0') *p++ = '\0';
+        int n = FamilyTree::splitRow(p, fld, FamilyTree::IMPORT_FIELDS);
+        if (n == 1 && fld[0][0] == '\0') n = 0;
+        return n;
+    }
+
+    static bool number(const char* v, int& out) { // non-negative decimal, false if malformed
+        out = 0;
+        if (v[0] == '\0') return false;
+        for (int i = 0; v[i] != '\0'; ++i) {
+            if (v[i] < '0' || v[i] > '9' || out > 100000000) return false;
+            out = out * 10 + (v[i] - '0');
+        }
+        return true;
+    }
+
+    // ---------- Scripted mode (--script FILE, or --script - for stdin) ----------
+    // One command per line, no prompts and no confirmations:
+    //   root NAME, GENDER[, ALIVE]
+    //   add NAME, GENDER[, ALIVE[, FATHER[, MOTHER]]]   unknown parents are created under root
+    //   late NAME
+    //   remove NAME                                     children move to their other parent or root
+    //   reparent NAME[, FATHER[, MOTHER]]               new parents (unknown ones created under root)
+    //   show [GENERATIONS[, FAMILIES]]                 0 = no limit, as in menu option 6
+    //   focus NAME[, UP[, DOWN]]                        tree around NAME (2 generations each way)
+    //   list
+    //   sorted [PREFIX[, FROM[, COUNT]]]                alphabetical, COUNT names from position FROM
+    //   search TEXT | prefix TEXT                       members containing / starting with TEXT
+    //   import FILE | save FILE | load FILE
+    //   checkpoint                                      fold the journal into its snapshot (--journal)
+    //   publish FILE                                    read-only image for --reader processes
+    //   export json|dot FILE                            JSON or Graphviz DOT (FILE - = standard output)
+    //   statistics                                      members per generation, alive / late, families
+    // Arguments are comma (or tab) separated like CSV import rows; blank lines and lines
+    // starting with # are skipped. Only command output goes to cout (renders of an unchanged
+    // tree are replayed from the cache); errors go to cerr as "line N: ...".
+    // Returns the number of failed lines.
+    int runScript(istream& in) {
+        char line[FamilyTree::IMPORT_LINE];
+        char* fld[FamilyTree::IMPORT_FIELDS];
+        int lineNo = 0, errors = 0;
+        auto fail = [&](const char* what) { cerr << "line " << lineNo << ": " << what << "\n"; ++errors; };
+        while (true) {
+            char* cmd = NULL;
+            bool tooLong;
+            int n = nextCommand(in, line, lineNo, cmd, fld, tooLong);
+            if (n == END_OF_SCRIPT) break;
+            if (n == NO_COMMAND) { if (tooLong) fail("line too long"); continue; }
+
+            if (FamilyTree::lowerEq(cmd, "add") || FamilyTree::lowerEq(cmd, "root")) {
+                bool isRoot = FamilyTree::lowerEq(cmd, "root");
+                FamilyTree::clipName(fld[0]);
+                FamilyTree::clipName(fld[3]);
+                FamilyTree::clipName(fld[4]);
+                auto same = [](const char* a, const char* b) { while (*a != '\0' && *a == *b) { ++a; ++b; } return *a == *b; };
+                char g = fld[1][0];
+                int alive = FamilyTree::parseAlive(fld[2]);
+                if (n < 2 || fld[0][0] == '\0') fail("expected NAME, GENDER");
+                else if (fld[1][1] != '\0' || !(g == 'M' || g == 'm' || g == 'F' || g == 'f')) fail("gender must be M or F");
+                else if (alive < 0) fail("alive must be y or n");
+                else if (isRoot && tree.hasRoot()) fail("root already exists");
+                else if (isRoot) tree.createRoot(fld[0], g, alive == 1);
+                else if (!tree.hasRoot()) fail("create root first");
+                else if (tree.find(fld[0])) fail("member already exists");
+                else if (same(fld[0], fld[3]) || same(fld[0], fld[4])) fail("a member cannot be its own parent");
+                else {
+                    FamilyMember* parent[2] = { NULL, NULL };
+                    for (int k = 0; k < 2; ++k) {
+                        if (fld[3 + k][0] == '\0') continue;
+                        parent[k] = tree.find(fld[3 + k]);
+                        if (!parent[k]) parent[k] = tree.addMember(fld[3 + k], k == 0 ? 'M' : 'F', true, NULL, NULL);
+                    }
+                    if (!tree.addMember(fld[0], g, alive == 1, parent[0], parent[1])) fail("member not added");
+                }
+            }
+            else if (FamilyTree::lowerEq(cmd, "late")) {
+                FamilyTree::clipName(fld[0]);
+                FamilyMember* m = n ? tree.find(fld[0]) : NULL;
+                if (!m) fail("member not found");
+                else tree.markLate(m);
+            }
+            else if (FamilyTree::lowerEq(cmd, "remove")) {
+                FamilyTree::clipName(fld[0]);
+                FamilyMember* m = n ? tree.find(fld[0]) : NULL;
+                if (!m) fail("member not found");
+                else if (!tree.removeMember(m)) fail("root cannot be removed");
+            }
+            else if (FamilyTree::lowerEq(cmd, "reparent")) {
+                FamilyTree::clipName(fld[0]);
+                FamilyMember* m = n ? tree.find(fld[0]) : NULL;
+                if (!m) fail("member not found");
+                else {
+                    FamilyMember* parent[2] = { NULL, NULL };
+                    for (int k = 0; k < 2; ++k) {
+                        FamilyTree::clipName(fld[1 + k]);
+                        if (fld[1 + k][0] == '\0') continue;
+                        parent[k] = tree.find(fld[1 + k]);
+                        if (!parent[k]) parent[k] = tree.addMember(fld[1 + k], k == 0 ? 'M' : 'F', true, NULL, NULL);
+                    }
+                    if (!tree.reparent(m, parent[0], parent[1])) fail("not allowed: root, own parent or own ancestor");
+                }
+            }
+            else if (FamilyTree::lowerEq(cmd, "show")) {
+                int limit[2] = { 0, 0 };
+                bool ok = true;
+                for (int k = 0; k < 2 && k < n; ++k) ok = number(fld[k], limit[k]) && ok;
+                if (!ok) fail("show takes non-negative numbers");
+                else if (!tree.hasRoot()) fail("no tree");
+                else tree.showCenteredTree(limit[0], limit[1]);
+            }
+            else if (FamilyTree::lowerEq(cmd, "focus")) {
+                int up = 2, down = 2;
+                FamilyTree::clipName(fld[0]);
+                FamilyMember* m = n ? tree.find(fld[0]) : NULL;
+                if (!m) fail("member not found");
+                else if ((n > 1 && !number(fld[1], up)) || (n > 2 && !number(fld[2], down))) fail("focus takes NAME, UP, DOWN");
+                else tree.showFocusedTree(m, up, down);
+            }
+            else if (FamilyTree::lowerEq(cmd, "list")) tree.showAllNames();
+            else if (FamilyTree::lowerEq(cmd, "statistics")) {
+                if (!tree.hasRoot()) fail("no tree");
+                else tree.showStatistics();
+            }
+            else if (FamilyTree::lowerEq(cmd, "sorted")) {
+                int from = 0, count = tree.memberCount();
+                FamilyTree::clipName(fld[0]);
+                if ((n > 1 && !number(fld[1], from)) || (n > 2 && !number(fld[2], count))) fail("sorted takes PREFIX, FROM, COUNT");
+                else tree.printNamePage(fld[0], from, count);
+            }
+            else if (FamilyTree::lowerEq(cmd, "search") || FamilyTree::lowerEq(cmd, "prefix")) {
+                if (n == 0 || fld[0][0] == '\0') fail("expected TEXT");
+                else tree.printSearch(fld[0], FamilyTree::lowerEq(cmd, "prefix"));
+            }
+            else if (FamilyTree::lowerEq(cmd, "import")) { if (n == 0 || !tree.importFile(fld[0])) fail("import failed"); }
+            else if (FamilyTree::lowerEq(cmd, "save")) { if (n == 0 || !tree.saveSnapshot(fld[0])) fail("save failed"); }
+            else if (FamilyTree::lowerEq(cmd, "load")) { if (n == 0 || !tree.loadSnapshot(fld[0])) fail("load failed"); }
+            else if (FamilyTree::lowerEq(cmd, "checkpoint")) { if (!tree.checkpoint()) fail("checkpoint failed"); }
+            else if (FamilyTree::lowerEq(cmd, "publish")) { if (n == 0 || !tree.publishImage(fld[0])) fail("publish failed"); }
+            else if (FamilyTree::lowerEq(cmd, "export")) {
+                // export FORMAT FILE: the format is the first word, the file the rest of the line
+                char* file = fld[0];
+                while (*file != '\0' && *file != ' ' && *file != '\t') ++file;
+                if (*file != '\0') *file++ = '\0';
+                while (*file == ' ' || *file == '\t') ++file;
+                bool dot = FamilyTree::lowerEq(fld[0], "dot");
+                if (n == 0 || (!dot && !FamilyTree::lowerEq(fld[0], "json"))) fail("export takes json or dot");
+                else if (*file == '\0') fail("expected FILE");
+                else if (!tree.exportTree(file, dot)) fail("export failed");
+            }
+            else fail("unknown command");
+            if (tree.versions().hasReaders()) tree.publishVersion();
+        }
+        cout.flush();
+        return errors;
+    }
+
+    // ---------- Reader mode (--reader IMAGE): read-only queries on a published image ----------
+    // Same line format as scripts, commands:
+    //   show                                            the full tree as published
+    //   find NAME                                       generation and status
+    //   ancestors NAME[, GENS] | descendants NAME[, GENS]   0 = no limit
+    // The image is mapped, never copied; nothing is written back. Returns the failed lines.
+    static int runReader(TreeImage& image, istream& in) {
+        char line[FamilyTree::IMPORT_LINE];
+        char* fld[FamilyTree::IMPORT_FIELDS];
+        int* found = NULL;
+        int* gens = NULL;
+        int lineNo = 0, errors = 0;
+        auto fail = [&](const char* what) { cerr << "line " << lineNo << ": " << what << "\n"; ++errors; };
+        while (true) {
+            char* cmd = NULL;
+            bool tooLong;
+            int n = nextCommand(in, line, lineNo, cmd, fld, tooLong);
+            if (n == END_OF_SCRIPT) break;
+            if (n == NO_COMMAND) { if (tooLong) fail("line too long"); continue; }
+
+            FamilyTree::clipName(fld[0]);
+            int who = n ? image.find(fld[0]) : -1;
+            if (FamilyTree::lowerEq(cmd, "show")) image.writeTree(cout);
+            else if (FamilyTree::lowerEq(cmd, "find")) {
+                if (who < 0) fail("member not found");
+                else cout << image.nameOf(who) << " (" << (image.isAlive(who) ? "Alive" : "Late")
+                          << "), generation " << image.generationOf(who) << "\n";
+            }
+            else if (FamilyTree::lowerEq(cmd, "ancestors") || FamilyTree::lowerEq(cmd, "descendants")) {
+                bool up = FamilyTree::lowerEq(cmd, "ancestors");
+                int limit = 0;
+                if (who < 0) fail("member not found");
+                else if (n > 1 && !number(fld[1], limit)) fail("expected NAME, GENERATIONS");
+                else {
+                    if (!found) { found = new int[image.size()]; gens = new int[image.size()]; }
+                    int k = image.lineage(who, up, limit, found, gens);
+                    cout << (up ? "Ancestors (" : "Descendants (") << k << "):\n";
+                    for (int i = 0; i < k; ++i)
+                        cout << "  " << image.nameOf(found[i]) << " (" << gens[i] << (up ? " up)\n" : " down)\n");
+                }
+            }
+            else fail("unknown command");
+        }
+        delete[] found;
+        delete[] gens;
+        cout.flush();
+        return errors;
+    }
+
+    void run() {
+        cout << "===== CENTERED FAMILY TREE SYSTEM =====\n";
+        while (true) {
+            cout << "\n1. Create Root Ancestor\n2. Add Member\n3. Mark Member as Late\n4. Show Centered Tree\n5. List All Members\n6. Show Tree (limit generations/width)\n7. Save Tree to File\n8. Load Tree from File\n9. Import Members (CSV/TSV)\n10. Show Ancestors / Descendants\n11. Show Relationship\n12. Instrumentation (on / report)\n13. Search Members by Name\n14. List Members Alphabetically\n15. Show Tree Around a Member\n16. Remove Member\n17. Change Parents\n18. Publish Read-Only Image\n19. Export Tree (JSON/DOT)\n20. Show Statistics\n0. Exit\nEnter choice: ";
+            int ch = readChoice();
+            if (ch == 0) {
+                tree.closeJournal();
+#ifdef FAMILY_TREE_STATS
+                if (Stats::enabled) Stats::report(cout);
+#endif
+                cout << "Exiting...\n";
+                break;
+            }
+            if (ch == 1) tree.createRootInteractive();
+            else if (ch == 2) tree.addMemberInteractive();
+            else if (ch == 3) tree.markLateInteractive();
+            else if (ch == 4) tree.showCenteredTree();
+            else if (ch == 5) tree.showAllNames();
+            else if (ch == 6) tree.showLimitedTreeInteractive();
+            else if (ch == 7) tree.saveInteractive();
+            else if (ch == 8) tree.loadInteractive();
+            else if (ch == 9) tree.importInteractive();
+            else if (ch == 10) tree.showLineageInteractive();
+            else if (ch == 11) tree.showRelationshipInteractive();
+            else if (ch == 12) toggleStats();
+            else if (ch == 13) tree.searchNamesInteractive();
+            else if (ch == 14) tree.listByNameInteractive();
+            else if (ch == 15) tree.showFocusedTreeInteractive();
+            else if (ch == 16) tree.removeMemberInteractive();
+            else if (ch == 17) tree.reparentInteractive();
+            else if (ch == 18) tree.publishInteractive();
+            else if (ch == 19) tree.exportInteractive();
+            else if (ch == 20) tree.showStatistics();
+            else cout << "Invalid choice.\n";
+            if (tree.versions().hasReaders()) tree.publishVersion();
+        }
+    }
+};
+// FAMILY_TREE_NO_MAIN: include this file for the classes only (see Benchmark.cpp)
+#ifndef FAMILY_TREE_NO_MAIN
+int main(int argc, char** argv) {
+    Menu m;
+    const char* script = NULL;
+    const char* journal = NULL;
+    const char* reader = NULL;
+    bool stats = false;
+    for (int i = 1; i < argc; ++i) {
+        if (Menu::isFlag(argv[i], "--stats")) stats = true; // count from the start, report on exit
+        else if (Menu::isFlag(argv[i], "--script") && i + 1 < argc) script = argv[++i];
+        else if (Menu::isFlag(argv[i], "--journal") && i + 1 < argc) journal = argv[++i];
+        else if (Menu::isFlag(argv[i], "--reader") && i + 1 < argc) reader = argv[++i];
+        else {
+            cerr << "usage: " << argv[0] << " [--stats] [--journal BASE] [--script FILE | --script -]\n"
+                 << "       " << argv[0] << " --reader IMAGE [--script FILE]   (queries on a published image)\n";
+            return 2;
+        }
+    }
+    if (reader) { // read-only: no tree, no journal; commands from the script or stdin
+        TreeImage image;
+        if (!image.open(reader)) { cerr << "Cannot map image '" << reader << "'.\n"; return 2; }
+        ios::sync_with_stdio(false);
+        int errors;
+        if (!script || Menu::isFlag(script, "-")) errors = Menu::runReader(image, cin);
+        else {
+            ifstream file(script, ios::binary);
+            if (!file) { cerr << "Cannot open script '" << script << "'.\n"; return 2; }
+            errors = Menu::runReader(image, file);
+        }
+        if (errors) cerr << errors << " command line(s) failed.\n";
+        return errors ? 1 : 0;
+    }
+    if (journal && !m.openJournal(journal)) return 2;
+    if (!script) {
+        if (stats) Menu::toggleStats();
+        m.run();
+        return 0;
+    }
+
+    // scripted: no prompts, C stdio sync off so output is only written in large blocks
+    ios::sync_with_stdio(false);
+#ifdef FAMILY_TREE_STATS
+    if (stats) { Stats::reset(); Stats::enabled = true; }
+#else
+    if (stats) cerr << "Instrumentation is not compiled in (rebuild with -DFAMILY_TREE_STATS).\n";
+#endif
+    int errors;
+    if (Menu::isFlag(script, "-")) errors = m.runScript(cin);
+    else {
+        ifstream file(script, ios::binary);
+        if (!file) { cerr << "Cannot open script '" << script << "'.\n"; return 2; }
+        errors = m.runScript(file);
+    }
+    m.closeJournal();
+#ifdef FAMILY_TREE_STATS
+    if (stats) Stats::report(cout);
+#endif
+    if (errors) cerr << errors << " script line(s) failed.\n";
+    return errors ? 1 : 0;
+}
+#endif
\ No newline at end of file